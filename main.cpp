@@ -2,12 +2,42 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <limits>
-#include <stack>
+#include <climits>
+#include <deque>
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <queue>
+#include <map>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <unordered_set>
+#include <cstring>
+#include <atomic>
+#ifdef _WIN32
+#define NOMINMAX  // keep std::min/std::max usable
 #include <windows.h>
+#include <conio.h>
+#include <io.h>
+#else
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#endif
 #include "json.hpp"
 
 using namespace std;
@@ -17,19 +47,33 @@ using json = nlohmann::json;
 // ANSI COLOR CODES
 // ═══════════════════════════════════════════════════════════════════
 
-#define RESET   "\033[0m"
-#define RED     "\033[38;5;131m"  // Muted red
-#define GREEN   "\033[38;5;108m"  // Sage green
-#define YELLOW  "\033[38;5;179m"  // Muted gold
-#define BLUE    "\033[38;5;67m"   // Slate blue
-#define MAGENTA "\033[38;5;132m"  // Dusty magenta
-#define CYAN    "\033[38;5;73m"   // Muted cyan
-#define BRIGHT_RED     "\033[38;5;167m"  // Soft coral
-#define BRIGHT_GREEN   "\033[38;5;114m"  // Soft green
-#define BRIGHT_YELLOW  "\033[38;5;185m"  // Soft yellow
-#define BRIGHT_BLUE    "\033[38;5;74m"   // Soft blue
-#define BRIGHT_MAGENTA "\033[38;5;139m"  // Soft mauve
-#define BRIGHT_CYAN    "\033[38;5;80m"   // Soft teal
+// Plain output (see setColors) swaps these for empty strings
+const char* RESET   = "\033[0m";
+const char* RED     = "\033[38;5;131m";  // Muted red
+const char* GREEN   = "\033[38;5;108m";  // Sage green
+const char* YELLOW  = "\033[38;5;179m";  // Muted gold
+const char* BLUE    = "\033[38;5;67m";   // Slate blue
+const char* MAGENTA = "\033[38;5;132m";  // Dusty magenta
+const char* CYAN    = "\033[38;5;73m";   // Muted cyan
+const char* BRIGHT_RED     = "\033[38;5;167m";  // Soft coral
+const char* BRIGHT_GREEN   = "\033[38;5;114m";  // Soft green
+const char* BRIGHT_YELLOW  = "\033[38;5;185m";  // Soft yellow
+const char* BRIGHT_BLUE    = "\033[38;5;74m";   // Soft blue
+const char* BRIGHT_MAGENTA = "\033[38;5;139m";  // Soft mauve
+const char* BRIGHT_CYAN    = "\033[38;5;80m";   // Soft teal
+
+const char** const COLOR_CODES[] = { &RESET, &RED, &GREEN, &YELLOW, &BLUE, &MAGENTA, &CYAN,
+                                      &BRIGHT_RED, &BRIGHT_GREEN, &BRIGHT_YELLOW, &BRIGHT_BLUE,
+                                      &BRIGHT_MAGENTA, &BRIGHT_CYAN };
+const char* const COLOR_VALUES[] = { RESET, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN,
+                                     BRIGHT_RED, BRIGHT_GREEN, BRIGHT_YELLOW, BRIGHT_BLUE,
+                                     BRIGHT_MAGENTA, BRIGHT_CYAN };
+
+void setColors(bool enabled) {
+    for (size_t i = 0; i < sizeof(COLOR_CODES) / sizeof(COLOR_CODES[0]); ++i) {
+        *COLOR_CODES[i] = enabled ? COLOR_VALUES[i] : "";
+    }
+}
 
 // ═══════════════════════════════════════════════════════════════════
 // DATA STRUCTURES
@@ -54,18 +98,134 @@ struct Task {
     bool completed = false;
     Priority priority = Priority::Medium;
     string dueDate;
+    uint32_t id = 0;    // stable across reordering and restarts
+    int64_t created = 0; // seconds since epoch, 0 = unknown
 };
 
 // ═══════════════════════════════════════════════════════════════════
 // GLOBAL STATE
 // ═══════════════════════════════════════════════════════════════════
 
-stack<vector<Task>> undoStack;
-stack<vector<Task>> redoStack;
+// Undo and redo step through changes to one task at a time, so reverting
+// one never overwrites what other processes saved since. Only the most
+// recent are kept; a long-running daemon would otherwise grow without bound.
+const size_t UNDO_LIMIT = 100;
+
+// A side with no task means the task did not exist then
+struct TaskChange {
+    bool hadBefore = false, hadAfter = false;
+    Task before, after;
+};
+
+deque<TaskChange> undoStack;
+deque<TaskChange> redoStack;
+
+// Bumped by every change to the task list; derived structures remember
+// the version they were built at. 0 is never a live version.
+uint64_t storeVersion = 1;
+uint32_t nextTaskId = 1;
+
+void touchStore() {
+    ++storeVersion;
+}
 
 // ═══════════════════════════════════════════════════════════════════
-// UI DISPLAY FUNCTIONS
+// INPUT BUFFER
+// ═══════════════════════════════════════════════════════════════════
+//
+// All of stdin goes through one block buffer. Line prompts, single
+// keystrokes and piped scripts share it, so nothing typed or piped ahead is
+// lost between them, and a long script costs one read per 64 KiB.
+
+const size_t INPUT_BLOCK = 1 << 16;
+
+class InputReader {
+public:
+    InputReader() : buffer_(INPUT_BLOCK) {}
+
+    bool buffered() const { return pos_ < end_; }
+
+    // A whole line is waiting, so readLine will not block
+    bool lineBuffered() const { return memchr(buffer_.data() + pos_, '\n', end_ - pos_) != nullptr; }
+
+    // Next byte, or EOF once stdin is exhausted
+    int get() {
+        if (pos_ == end_ && !fill()) return EOF;
+        return (unsigned char)buffer_[pos_++];
+    }
+
+    // Next line without its "\n" or "\r\n"; false at end of input
+    bool readLine(string& line) {
+        line.clear();
+        while (true) {
+            if (pos_ == end_ && !fill()) return !line.empty();
+            const char* start = buffer_.data() + pos_;
+            const char* newline = (const char*)memchr(start, '\n', end_ - pos_);
+            if (newline) {
+                line.append(start, newline - start);
+                pos_ += newline - start + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            line.append(start, end_ - pos_);
+            pos_ = end_;
+        }
+    }
+
+private:
+    bool fill() {
+        cout.flush();   // a prompt must be visible before blocking on input
+#ifdef _WIN32
+        int n = _read(0, buffer_.data(), (unsigned)buffer_.size());
+#else
+        ssize_t n;
+        do {
+            n = read(STDIN_FILENO, buffer_.data(), buffer_.size());
+        } while (n < 0 && errno == EINTR);
+#endif
+        pos_ = 0;
+        end_ = n > 0 ? (size_t)n : 0;
+        return end_ > 0;
+    }
+
+    vector<char> buffer_;
+    size_t pos_ = 0;
+    size_t end_ = 0;
+};
+
+InputReader stdinInput;
+
+// Leading integer after optional blanks and sign; the rest of the text is
+// ignored, as `cin >> v` did. False without digits or on overflow.
+bool parseInt(const string& text, int& value) {
+    size_t i = text.find_first_not_of(" \t");
+    if (i == string::npos) return false;
+
+    bool negative = text[i] == '-';
+    if (text[i] == '-' || text[i] == '+') ++i;
+    if (i >= text.size() || text[i] < '0' || text[i] > '9') return false;
+
+    int64_t v = 0;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+        v = v * 10 + (text[i] - '0');
+        if (v > (int64_t)numeric_limits<int>::max() + 1) return false;
+    }
+    if (negative) v = -v;
+    if (v > numeric_limits<int>::max()) return false;
+    value = (int)v;
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// TERMINAL
 // ═══════════════════════════════════════════════════════════════════
+//
+// Everything platform-specific about the console lives here: the console
+// API on Windows, termios and ioctl on POSIX systems.
+
+const int KEY_IGNORED = 0x100;   // arrow and function keys, which nothing binds yet
+
+#ifdef _WIN32
 
 void setupConsole() {
     SetConsoleOutputCP(CP_UTF8);
@@ -78,444 +238,5365 @@ void setupConsole() {
     SetConsoleMode(hOut, dwMode);
 }
 
-string getGradientColor(int lineIndex, int colIndex, int frame) {
-    const string colors[] = {
-        "\033[38;5;131m", // Muted red
-        "\033[38;5;137m", // Terracotta
-        "\033[38;5;173m", // Soft orange
-        "\033[38;5;179m", // Muted gold
-        "\033[38;5;185m", // Soft yellow
-        "\033[38;5;186m", // Pale yellow
-        "\033[38;5;150m", // Yellow-sage
-        "\033[38;5;114m", // Soft green
-        "\033[38;5;108m", // Sage
-        "\033[38;5;72m",  // Teal-green
-        "\033[38;5;73m",  // Muted cyan
-        "\033[38;5;80m",  // Soft teal
-        "\033[38;5;74m",  // Soft blue
-        "\033[38;5;67m",  // Slate blue
-        "\033[38;5;61m",  // Deeper slate
-        "\033[38;5;97m",  // Soft purple
-        "\033[38;5;103m", // Lavender
-        "\033[38;5;139m", // Mauve
-        "\033[38;5;132m", // Dusty magenta
-        "\033[38;5;168m"  // Soft rose
-    };
-    // 45-degree diagonal: both lineIndex and colIndex contribute equally
-    int colorIndex = (lineIndex + colIndex + frame) % 20;
-    return colors[colorIndex];
+// Visible height of the console window, not of its scrollback buffer
+int terminalRows() {
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        return info.srWindow.Bottom - info.srWindow.Top + 1;
+    }
+    return 24;
 }
 
-void displayWelcomeBanner() {
-    const int frames = 40;
-    const int delay_ms = 80;
-    
-    for (int frame = 0; frame < frames; ++frame) {
-        // Use ANSI cursor positioning instead of cls to reduce flicker
-        cout << "\033[H\033[2J"; // Clear screen and move to home
-        
-        cout << "\n";
-        cout << "  " << getGradientColor(0, 0, frame) << "╔════════════════════════════════════════════════════════════════════════════════════════════════╗" << RESET << "\n";
-        cout << "  " << getGradientColor(0, 0, frame) << "║" << RESET << "                                                                                                " << getGradientColor(0, 95, frame) << "║" << RESET << "\n";
-        
-        cout << "  " << getGradientColor(1, 0, frame) << "║" << RESET << "    " << getGradientColor(1, 4, frame) << "████████╗ █████╗ ███████╗██╗  ██╗    ███╗   ███╗ █████╗ ███████╗████████╗███████╗██████╗ " << RESET << " " << getGradientColor(1, 95, frame) << "  ║" << RESET << "\n";
-        cout << "  " << getGradientColor(2, 0, frame) << "║" << RESET << "    " << getGradientColor(2, 4, frame) << "╚══██╔══╝██╔══██╗██╔════╝██║ ██╔╝    ████╗ ████║██╔══██╗██╔════╝╚══██╔══╝██╔════╝██╔══██╗" << RESET << " " << getGradientColor(2, 95, frame) << "  ║" << RESET << "\n";
-        cout << "  " << getGradientColor(3, 0, frame) << "║" << RESET << "       " << getGradientColor(3, 7, frame) << "██║   ███████║███████╗█████╔╝     ██╔████╔██║███████║███████╗   ██║   █████╗  ██████╔╝" << RESET << " " << getGradientColor(3, 95, frame) << "  ║" << RESET << "\n";
-        cout << "  " << getGradientColor(5, 0, frame) << "║" << RESET << "       " << getGradientColor(5, 7, frame) << "██║   ██╔══██║╚════██║██╔═██╗     ██║╚██╔╝██║██╔══██║╚════██║   ██║   ██╔══╝  ██╔══██╗" << RESET << " " << getGradientColor(5, 95, frame) << "  ║" << RESET << "\n";
-        cout << "  " << getGradientColor(6, 0, frame) << "║" << RESET << "       " << getGradientColor(6, 7, frame) << "██║   ██║  ██║███████║██║  ██╗    ██║ ╚═╝ ██║██║  ██║███████║   ██║   ███████╗██║  ██║" << RESET << " " << getGradientColor(6, 95, frame) << "  ║" << RESET << "\n";
-        cout << "  " << getGradientColor(7, 0, frame) << "║" << RESET << "       " << getGradientColor(7, 7, frame) << "╚═╝   ╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝    ╚═╝     ╚═╝╚═╝  ╚═╝╚══════╝   ╚═╝   ╚══════╝╚═╝  ╚═╝" << RESET << " " << getGradientColor(7, 95, frame) << "  ║" << RESET << "\n";
-        cout << "  " << getGradientColor(8, 0, frame) << "║" << RESET << "                                                                                                " << getGradientColor(8, 95, frame) << "║" << RESET << "\n";
-        cout << "  " << getGradientColor(9, 0, frame) << "║" << RESET << "                                 " << getGradientColor(9, 33, frame) << "Advanced Task Management System" << RESET << "                                " << getGradientColor(9, 95, frame) << "║" << RESET << "\n";
-        cout << "  " << getGradientColor(10, 0, frame) << "║" << RESET << "                           " << getGradientColor(10, 27, frame) << "Priority Tracking • Undo/Redo • Search & Sort" << RESET << "                        " << getGradientColor(10, 95, frame) << "║" << RESET << "\n";
-        cout << "  " << getGradientColor(11, 0, frame) << "║" << RESET << "                                                                                                " << getGradientColor(11, 95, frame) << "║" << RESET << "\n";
-        cout << "  " << getGradientColor(12, 0, frame) << "╚════════════════════════════════════════════════════════════════════════════════════════════════╝" << RESET << "\n";
-        
-        cout << flush;
-        this_thread::sleep_for(chrono::milliseconds(delay_ms));
+int terminalCols() {
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        return info.srWindow.Right - info.srWindow.Left + 1;
     }
-    
-    // Display final static banner with last frame colors
-    cout << "\033[H\033[2J"; // Clear screen
-    cout << "\n";
-    cout << "  " << getGradientColor(0, 0, frames-1) << "╔════════════════════════════════════════════════════════════════════════════════════════════════╗" << RESET << "\n";
-    cout << "  " << getGradientColor(0, 0, frames-1) << "║" << RESET << "                                                                                                " << getGradientColor(0, 95, frames-1) << "║" << RESET << "\n";
-    
-    cout << "  " << getGradientColor(1, 0, frames-1) << "║" << RESET << "    " << getGradientColor(1, 4, frames-1) << "████████╗ █████╗ ███████╗██╗  ██╗    ███╗   ███╗ █████╗ ███████╗████████╗███████╗██████╗ " << RESET << " " << getGradientColor(1, 95, frames-1) << "  ║" << RESET << "\n";
-    cout << "  " << getGradientColor(2, 0, frames-1) << "║" << RESET << "    " << getGradientColor(2, 4, frames-1) << "╚══██╔══╝██╔══██╗██╔════╝██║ ██╔╝    ████╗ ████║██╔══██╗██╔════╝╚══██╔══╝██╔════╝██╔══██╗" << RESET << " " << getGradientColor(2, 95, frames-1) << "  ║" << RESET << "\n";
-    cout << "  " << getGradientColor(3, 0, frames-1) << "║" << RESET << "       " << getGradientColor(3, 7, frames-1) << "██║   ███████║███████╗█████╔╝     ██╔████╔██║███████║███████╗   ██║   █████╗  ██████╔╝" << RESET << " " << getGradientColor(3, 95, frames-1) << "  ║" << RESET << "\n";
-    cout << "  " << getGradientColor(5, 0, frames-1) << "║" << RESET << "       " << getGradientColor(5, 7, frames-1) << "██║   ██╔══██║╚════██║██╔═██╗     ██║╚██╔╝██║██╔══██║╚════██║   ██║   ██╔══╝  ██╔══██╗" << RESET << " " << getGradientColor(5, 95, frames-1) << "  ║" << RESET << "\n";
-    cout << "  " << getGradientColor(6, 0, frames-1) << "║" << RESET << "       " << getGradientColor(6, 7, frames-1) << "██║   ██║  ██║███████║██║  ██╗    ██║ ╚═╝ ██║██║  ██║███████║   ██║   ███████╗██║  ██║" << RESET << " " << getGradientColor(6, 95, frames-1) << "  ║" << RESET << "\n";
-    cout << "  " << getGradientColor(7, 0, frames-1) << "║" << RESET << "       " << getGradientColor(7, 7, frames-1) << "╚═╝   ╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝    ╚═╝     ╚═╝╚═╝  ╚═╝╚══════╝   ╚═╝   ╚══════╝╚═╝  ╚═╝" << RESET << " " << getGradientColor(7, 95, frames-1) << "  ║" << RESET << "\n";
-    cout << "  " << getGradientColor(8, 0, frames-1) << "║" << RESET << "                                                                                                " << getGradientColor(8, 95, frames-1) << "║" << RESET << "\n";
-    cout << "  " << getGradientColor(9, 0, frames-1) << "║" << RESET << "                                 " << getGradientColor(9, 33, frames-1) << "Advanced Task Management System" << RESET << "                                " << getGradientColor(9, 95, frames-1) << "║" << RESET << "\n";
-    cout << "  " << getGradientColor(10, 0, frames-1) << "║" << RESET << "                           " << getGradientColor(10, 27, frames-1) << "Priority Tracking • Undo/Redo • Search & Sort" << RESET << "                        " << getGradientColor(10, 95, frames-1) << "║" << RESET << "\n";
-    cout << "  " << getGradientColor(11, 0, frames-1) << "║" << RESET << "                                                                                                " << getGradientColor(11, 95, frames-1) << "║" << RESET << "\n";
-    cout << "  " << getGradientColor(12, 0, frames-1) << "╚════════════════════════════════════════════════════════════════════════════════════════════════╝" << RESET << "\n";
+    return 80;
 }
 
-void displayMenu() {
-    cout << "\n";
-    cout << "  ============================= MAIN MENU =============================\n";
-    cout << "  1. [+] Add Task             5. [?] Search Tasks\n";
-    cout << "  2. [=] View Tasks           6. [*] Sort Tasks\n";
-    cout << "  3. [~] Edit Task            7. [<] Undo\n";
-    cout << "  4. [X] Delete Task          8. [>] Redo\n";
-    cout << "                              9. [!] Exit\n";
-    cout << "  ====================================================================\n";
+bool outputIsTerminal() {
+    return _isatty(_fileno(stdout)) != 0;
+}
+
+bool inputIsTerminal() {
+    return _isatty(_fileno(stdin)) != 0;
+}
+
+// _getch() already reads single unechoed keystrokes
+struct RawMode {
+    RawMode() {}
+};
+
+bool keyPressed() {
+    return _kbhit() != 0;
+}
+
+int readKey() {
+    if (!inputIsTerminal()) return stdinInput.get();
+
+    int key = _getch();
+    if (key == 0 || key == 224) {
+        _getch();  // second byte of arrow/function keys
+        return KEY_IGNORED;
+    }
+    return key;
+}
+
+#else
+
+const int ESCAPE_TIMEOUT_MS = 30;   // a lone Esc is not followed by the rest of a sequence
+
+termios savedTermios;
+bool termiosSaved = false;
+volatile sig_atomic_t terminalResized = 1;
+winsize terminalSize;
+
+void onResize(int) {
+    terminalResized = 1;
+}
+
+// Puts the line discipline back if a signal ends us while in raw mode
+void onTerminate(int sig) {
+    if (termiosSaved) tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+void setupConsole() {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onResize;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &sa, nullptr);
+
+    signal(SIGINT, onTerminate);
+    signal(SIGTERM, onTerminate);
+}
+
+// Queried again only after SIGWINCH reports a resize
+const winsize& currentTerminalSize() {
+    if (terminalResized) {
+        terminalResized = 0;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &terminalSize) != 0 || terminalSize.ws_row == 0) {
+            terminalSize.ws_row = 24;
+            terminalSize.ws_col = 80;
+        }
+    }
+    return terminalSize;
+}
+
+int terminalRows() {
+    return currentTerminalSize().ws_row;
+}
+
+int terminalCols() {
+    return currentTerminalSize().ws_col;
+}
+
+bool outputIsTerminal() {
+    return isatty(STDOUT_FILENO) != 0;
+}
+
+bool inputIsTerminal() {
+    return isatty(STDIN_FILENO) != 0;
+}
+
+// While one of these is alive keystrokes arrive one at a time, unechoed.
+// Signals stay enabled so Ctrl+C still works.
+struct RawMode {
+    RawMode() {
+        if (!inputIsTerminal() || tcgetattr(STDIN_FILENO, &savedTermios) != 0) return;
+        termios raw = savedTermios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        termiosSaved = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+
+    ~RawMode() {
+        if (termiosSaved) tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+        termiosSaved = false;
+    }
+
+    RawMode(const RawMode&) = delete;
+    RawMode& operator=(const RawMode&) = delete;
+};
+
+bool waitForInput(int timeoutMs) {
+    if (stdinInput.buffered()) return true;
+    pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&fd, 1, timeoutMs) > 0;
+}
+
+bool keyPressed() {
+    return inputIsTerminal() && waitForInput(0);
+}
+
+int readKey() {
+    if (!inputIsTerminal()) return stdinInput.get();
+
+    int key = stdinInput.get();
+    if (key != 27 || !waitForInput(ESCAPE_TIMEOUT_MS)) return key;
+
+    // ESC [ params final, or ESC O x: swallow the whole sequence
+    int next = stdinInput.get();
+    if (next == '[') {
+        do {
+            key = stdinInput.get();
+        } while (key != EOF && (key < 0x40 || key > 0x7E));
+    } else if (next == 'O') {
+        stdinInput.get();
+    }
+    return KEY_IGNORED;
 }
 
+#endif
+
 // ═══════════════════════════════════════════════════════════════════
-// INPUT HELPER FUNCTIONS
+// RENDERING
+// ═══════════════════════════════════════════════════════════════════
+//
+// Rows are formatted straight into reusable byte buffers (no iostreams,
+// no temporary strings) and handed to the terminal in a single write.
+
+struct Literal {
+    const char* text;
+    size_t length;
+};
+
+#define LITERAL(s) { s, sizeof(s) - 1 }
+
+// How task rows are written: colored for terminals, plain when piped, or
+// one record per line for scripts (--format tsv|jsonl)
+enum class OutputFormat { Color, Plain, Tsv, Jsonl };
+
+OutputFormat outputFormat = OutputFormat::Color;
+
+// Indexed by [plain][(int)Priority]; the colors are GREEN, YELLOW and RED
+const Literal PRIORITY_SYMBOLS[2][3] = {
+    { LITERAL("\033[38;5;108m[L]\033[0m"), LITERAL("\033[38;5;179m[M]\033[0m"), LITERAL("\033[38;5;131m[H]\033[0m") },
+    { LITERAL("[L]"), LITERAL("[M]"), LITERAL("[H]") }
+};
+
+// Reused between renders so its capacity is only grown once
+string outputBuffer;
+
+void appendLiteral(string& out, const Literal& lit) {
+    out.append(lit.text, lit.length);
+}
+
+void appendNumber(string& out, uint64_t v) {
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    out.append(p, digits + sizeof(digits) - p);
+}
+
+// Tabs and newlines would split the record
+void appendTsvField(string& out, const string& text) {
+    for (char c : text) out += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+}
+
+void appendJsonString(string& out, const string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    const char* hex = "0123456789abcdef";
+                    out.append("\\u00", 4);
+                    out += hex[c >> 4];
+                    out += hex[c & 15];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// TSV rows: number, id, done (yes/no), priority (H/M/L), due date, title
+void appendTsvBody(string& out, const Task& t) {
+    out += '\t';
+    appendNumber(out, t.id);
+    out.append(t.completed ? "\tyes\t" : "\tno\t");
+    out += priorityToString(t.priority);
+    out += '\t';
+    out += t.dueDate;
+    out += '\t';
+    appendTsvField(out, t.title);
+}
+
+void appendJsonBody(string& out, const Task& t) {
+    out.append(",\"id\":");
+    appendNumber(out, t.id);
+    out.append(",\"title\":");
+    appendJsonString(out, t.title);
+    out.append(t.completed ? ",\"completed\":true" : ",\"completed\":false");
+    out.append(",\"priority\":\"");
+    out += priorityToString(t.priority);
+    out.append("\",\"dueDate\":");
+    appendJsonString(out, t.dueDate);
+    out += '}';
+}
+
+void appendTextBody(string& out, const Task& t) {
+    out.append(t.completed ? ". [V] " : ". [ ] ", 6);
+    appendLiteral(out, PRIORITY_SYMBOLS[outputFormat != OutputFormat::Color][(int)t.priority]);
+    out += ' ';
+    out += t.title;
+
+    if (!t.dueDate.empty()) {
+        out.append(" (Due: ", 7);
+        out += t.dueDate;
+        out += ')';
+    }
+}
+
+// Everything in a row after its display number, by task id. Numbers shift
+// whenever the view changes, so keeping them out means only editing or
+// deleting a task invalidates its entry; the change hooks drop it then.
+// The daemon renders in each client's format, so bodies are kept per format.
+struct RowCache {
+    uint64_t version = 0;
+    vector<string> bodies[4];   // by OutputFormat; empty until first rendered
+};
+
+RowCache rowCache;
+
+const string& cachedRowBody(const Task& t) {
+    if (rowCache.version != storeVersion) {
+        for (auto& b : rowCache.bodies) b.clear();
+        rowCache.version = storeVersion;
+    }
+    vector<string>& bodies = rowCache.bodies[(int)outputFormat];
+    if (t.id >= bodies.size()) {
+        bodies.resize(max<size_t>(t.id + 1, bodies.size() * 2));
+    }
+
+    string& body = bodies[t.id];
+    if (body.empty()) {
+        if (outputFormat == OutputFormat::Tsv) appendTsvBody(body, t);
+        else if (outputFormat == OutputFormat::Jsonl) appendJsonBody(body, t);
+        else appendTextBody(body, t);
+    }
+    return body;
+}
+
+void forgetRowBody(uint32_t id) {
+    for (auto& bodies : rowCache.bodies) {
+        if (id < bodies.size()) bodies[id].clear();
+    }
+}
+
+void appendTaskRow(string& out, const Task& t, size_t number) {
+    if (outputFormat == OutputFormat::Jsonl) out.append("{\"number\":", 10);
+    else if (outputFormat != OutputFormat::Tsv) out.append("  ", 2);
+    appendNumber(out, number);
+    out += cachedRowBody(t);
+}
+
+const char* const OUTPUT_FORMAT_NAMES[] = { "color", "plain", "tsv", "jsonl" };
+
+bool parseOutputFormat(const string& name, OutputFormat& format) {
+    for (int i = 0; i < 4; ++i) {
+        if (name != OUTPUT_FORMAT_NAMES[i]) continue;
+        format = (OutputFormat)i;
+        return true;
+    }
+    return false;
+}
+
+// Switches row rendering and the message colors together
+void useOutputFormat(OutputFormat format) {
+    outputFormat = format;
+    setColors(format == OutputFormat::Color);
+}
+
+// Removes "--format NAME" from the arguments and applies it; without one,
+// colors are used only when stdout is a terminal. False for unknown names.
+bool takeOutputFormat(vector<string>& args) {
+    OutputFormat format = outputIsTerminal() ? OutputFormat::Color : OutputFormat::Plain;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != "--format") continue;
+        string name = i + 1 < args.size() ? args[i + 1] : "";
+        if (!parseOutputFormat(name, format)) return false;
+        args.erase(args.begin() + i, args.begin() + i + 2);
+        break;
+    }
+    useOutputFormat(format);
+    return true;
+}
+
+string formatTaskRow(const Task& t, size_t number) {
+    string line;
+    appendTaskRow(line, t, number);
+    return line;
+}
+
+// Emits the buffer with one write, after anything still queued in cout
+void writeOutput(const string& out) {
+    cout.flush();
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+}
+
+// Renders synthetic rows to the null device and reports rows per second
+void runRenderBenchmark(size_t rows) {
+    vector<Task> tasks(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        tasks[i].id = (uint32_t)i + 1;
+        tasks[i].title = "Benchmark task number " + to_string(i);
+        tasks[i].completed = (i % 3 == 0);
+        tasks[i].priority = (Priority)(i % 3);
+        if (i % 2 == 0) tasks[i].dueDate = "2026-11-01";
+    }
+
+#ifdef _WIN32
+    FILE* sink = fopen("NUL", "wb");
+#else
+    FILE* sink = fopen("/dev/null", "wb");
+#endif
+    if (!sink) {
+        cout << "  " << RED << "[X]" << RESET << " Cannot open the null device.\n";
+        return;
+    }
+
+    const int rounds = 5;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        outputBuffer.clear();
+        for (size_t i = 0; i < rows; ++i) {
+            appendTaskRow(outputBuffer, tasks[i], i + 1);
+            outputBuffer += '\n';
+        }
+        fwrite(outputBuffer.data(), 1, outputBuffer.size(), sink);
+        fflush(sink);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fclose(sink);
+
+    cout << "  Rendered " << rows << " rows x " << rounds << " rounds in " << seconds * 1000.0 << " ms: "
+         << (size_t)((double)rows * rounds / seconds) << " rows/second ("
+         << outputBuffer.size() * rounds / seconds / (1024.0 * 1024.0) << " MiB/s)\n";
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// SCREEN
+// ═══════════════════════════════════════════════════════════════════
+//
+// Full-screen output goes through a Screen. Callers paint its back buffer;
+// flush() compares that with the front buffer (what the terminal already
+// shows) and writes only the cells that changed, so an animation frame or a
+// page flip costs bytes in proportion to what actually differs.
+
+const uint32_t UNKNOWN_GLYPH = 0xFFFFFFFF;  // front cell whose on-screen content is unknown
+const int CURSOR_SKIP_MAX = 4;              // reprint up to this many cells instead of moving the cursor
+
+struct Cell {
+    uint32_t glyph = ' ';   // Unicode code point
+    int16_t fg = -1;        // 256-color index, -1 for the default color
+};
+
+bool operator==(const Cell& a, const Cell& b) {
+    return a.glyph == b.glyph && a.fg == b.fg;
+}
+
+bool operator!=(const Cell& a, const Cell& b) {
+    return !(a == b);
+}
+
+void appendUtf8(string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// Decodes the sequence starting at text[i] and advances i past it;
+// malformed bytes come back as '?'
+uint32_t decodeUtf8(const string& text, size_t& i) {
+    unsigned char lead = (unsigned char)text[i++];
+    if (lead < 0x80) return lead;
+
+    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || i + extra > text.size()) return '?';
+    uint32_t cp = lead & (0x3F >> extra);
+    for (int k = 0; k < extra; ++k) {
+        unsigned char b = (unsigned char)text[i];
+        if ((b & 0xC0) != 0x80) return '?';
+        cp = (cp << 6) | (b & 0x3F);
+        ++i;
+    }
+    return cp;
+}
+
+// Code points that take two terminal cells: East Asian Wide and Fullwidth
+// blocks and the emoji most often seen in titles
+const uint32_t WIDE_RANGES[][2] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+    {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+    {0x17000, 0x18AFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+    {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F64F},
+    {0x1F680, 0x1F6FF}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+    {0x30000, 0x3FFFD}
+};
+
+// Combining marks, joiners, variation selectors and other code points that
+// modify the previous glyph instead of taking a cell
+const uint32_t ZERO_WIDTH_RANGES[][2] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E},
+    {0x1160, 0x11FF}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+    {0x2028, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F},
+    {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0x1F3FB, 0x1F3FF}, {0xE0000, 0xE007F},
+    {0xE0100, 0xE01EF}
+};
+
+template <size_t N>
+bool inRanges(const uint32_t (&ranges)[N][2], uint32_t cp) {
+    size_t lo = 0, hi = N;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp > ranges[mid][1]) lo = mid + 1;
+        else if (cp < ranges[mid][0]) hi = mid;
+        else return true;
+    }
+    return false;
+}
+
+// Terminal cells taken by one code point
+int codepointWidth(uint32_t cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (cp < 0x300) return 1;
+    if (inRanges(ZERO_WIDTH_RANGES, cp)) return 0;
+    return inRanges(WIDE_RANGES, cp) ? 2 : 1;
+}
+
+size_t displayWidth(const string& text) {
+    size_t width = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = (unsigned char)text[i];
+        if (c < 0x80) {
+            width += c >= 0x20 && c != 0x7F;
+            ++i;
+        } else {
+            width += codepointWidth(decodeUtf8(text, i));
+        }
+    }
+    return width;
+}
+
+const uint32_t WIDE_TAIL = 0xFFFFFFFE;   // second cell of a two-cell glyph; emits nothing
+
+class Screen {
+public:
+    Screen(int rows, int cols)
+        : rows_(rows), cols_(cols), front_(rows * cols), back_(rows * cols) {}
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+    // Forgets everything on the terminal; the next flush clears and repaints it
+    void invalidate() { cleared_ = false; }
+
+    // Forgets one row, e.g. after the user typed a line of input on it
+    void invalidateRow(int row) {
+        if (row < 0 || row >= rows_) return;
+        for (int c = 0; c < cols_; ++c) front_[row * cols_ + c].glyph = UNKNOWN_GLYPH;
+    }
+
+    void clear() {
+        fill(back_.begin(), back_.end(), Cell());
+    }
+
+    // Paints text from (row, col), clipped to the screen. Newlines return to
+    // the starting column one row down; the SGR color codes this program
+    // emits are applied and any other escape sequence is dropped. Returns
+    // the column after the last glyph.
+    int draw(int row, int col, const string& text) {
+        int startCol = col;
+        int16_t fg = -1;
+        size_t i = 0;
+        while (i < text.size()) {
+            char ch = text[i];
+            if (ch == '\n') {
+                ++row;
+                col = startCol;
+                ++i;
+                continue;
+            }
+            if (ch == '\033' && i + 1 < text.size() && text[i + 1] == '[') {
+                size_t end = i + 2;
+                while (end < text.size() && (text[end] < 0x40 || text[end] > 0x7E)) ++end;
+                if (end < text.size() && text[end] == 'm') fg = sgrColor(text.substr(i + 2, end - i - 2), fg);
+                i = end + 1;
+                continue;
+            }
+            uint32_t cp = decodeUtf8(text, i);
+            int width = codepointWidth(cp);
+            if (width == 0) continue;   // a cell holds one code point, so marks are dropped
+            if (row >= 0 && row < rows_ && col >= 0 && col < cols_) {
+                if (width == 2 && col + 1 == cols_) cp = ' ';   // no room for the second half
+                put(row, col, cp, cp == ' ' ? -1 : fg);   // color is invisible on a blank
+                if (width == 2 && col + 1 < cols_) put(row, col + 1, WIDE_TAIL, fg);
+            }
+            col += width;
+        }
+        return col;
+    }
+
+    // Where the cursor is left after a flush
+    void placeCursor(int row, int col) {
+        cursorRow_ = row;
+        cursorCol_ = col;
+    }
+
+    void flush() {
+        writeOutput(diff());
+    }
+
+    // The bytes that bring the terminal from the front buffer to the back
+    // buffer; the front buffer is updated as if they had been written
+    string diff() {
+        string out;
+        int row = -1, col = -1;   // terminal cursor, -1 while unknown
+        int16_t fg = -1;
+
+        if (!cleared_) {
+            out += "\033[0m\033[H\033[2J";
+            fill(front_.begin(), front_.end(), Cell());
+            cleared_ = true;
+            row = col = 0;
+        }
+
+        for (int r = 0; r < rows_; ++r) {
+            for (int c = 0; c < cols_; ++c) {
+                const Cell& want = back_[r * cols_ + c];
+                if (front_[r * cols_ + c] == want) continue;
+
+                if (r == row && c > col && c - col <= CURSOR_SKIP_MAX) {
+                    for (; col < c; ++col) emitCell(out, back_[r * cols_ + col], fg);
+                } else if (r != row || c != col) {
+                    appendCursorMove(out, r, c);
+                }
+                emitCell(out, want, fg);
+                front_[r * cols_ + c] = want;
+                row = r;
+                col = c + 1;
+            }
+        }
+
+        if (fg != -1) out += RESET;
+        appendCursorMove(out, cursorRow_, cursorCol_);
+        return out;
+    }
+
+private:
+    // Overwriting half of a two-cell glyph blanks the other half
+    void put(int row, int col, uint32_t glyph, int16_t fg) {
+        Cell* line = &back_[row * cols_];
+        if (glyph != WIDE_TAIL && line[col].glyph == WIDE_TAIL && col > 0) line[col - 1] = Cell();
+        if (col + 1 < cols_ && line[col + 1].glyph == WIDE_TAIL) line[col + 1] = Cell();
+        line[col].glyph = glyph;
+        line[col].fg = fg;
+    }
+
+    static int16_t sgrColor(const string& params, int16_t current) {
+        if (params.empty() || params == "0") return -1;
+        if (params.compare(0, 5, "38;5;") == 0) return (int16_t)atoi(params.c_str() + 5);
+        return current;
+    }
+
+    static void appendCursorMove(string& out, int row, int col) {
+        out += "\033[";
+        appendNumber(out, row + 1);
+        out += ';';
+        appendNumber(out, col + 1);
+        out += 'H';
+    }
+
+    static void emitCell(string& out, const Cell& cell, int16_t& fg) {
+        if (cell.glyph == WIDE_TAIL) return;
+        if (cell.glyph != ' ' && cell.fg != fg) {
+            if (cell.fg < 0) {
+                out += RESET;
+            } else {
+                out += "\033[38;5;";
+                appendNumber(out, cell.fg);
+                out += 'm';
+            }
+            fg = cell.fg;
+        }
+        appendUtf8(out, cell.glyph);
+    }
+
+    int rows_, cols_;
+    vector<Cell> front_, back_;
+    bool cleared_ = false;
+    int cursorRow_ = 0, cursorCol_ = 0;
+};
+
+// ═══════════════════════════════════════════════════════════════════
+// UI DISPLAY FUNCTIONS
 // ═══════════════════════════════════════════════════════════════════
 
-int readInt(const string& prompt) {
-    int v;
-    while (true) {
-        cout << "  " << prompt;
-        cin >> v;
-        if (!cin.fail()) {
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return v;
-        }
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        cout << "  " << RED << "[X]" << RESET << " Invalid number. Please try again.\n";
+constexpr Literal GRADIENT[] = {
+    LITERAL("\033[38;5;131m"),  // Muted red
+    LITERAL("\033[38;5;137m"),  // Terracotta
+    LITERAL("\033[38;5;173m"),  // Soft orange
+    LITERAL("\033[38;5;179m"),  // Muted gold
+    LITERAL("\033[38;5;185m"),  // Soft yellow
+    LITERAL("\033[38;5;186m"),  // Pale yellow
+    LITERAL("\033[38;5;150m"),  // Yellow-sage
+    LITERAL("\033[38;5;114m"),  // Soft green
+    LITERAL("\033[38;5;108m"),  // Sage
+    LITERAL("\033[38;5;72m"),   // Teal-green
+    LITERAL("\033[38;5;73m"),   // Muted cyan
+    LITERAL("\033[38;5;80m"),   // Soft teal
+    LITERAL("\033[38;5;74m"),   // Soft blue
+    LITERAL("\033[38;5;67m"),   // Slate blue
+    LITERAL("\033[38;5;61m"),   // Deeper slate
+    LITERAL("\033[38;5;97m"),   // Soft purple
+    LITERAL("\033[38;5;103m"),  // Lavender
+    LITERAL("\033[38;5;139m"),  // Mauve
+    LITERAL("\033[38;5;132m"),  // Dusty magenta
+    LITERAL("\033[38;5;168m")   // Soft rose
+};
+
+const int GRADIENT_STEPS = sizeof(GRADIENT) / sizeof(GRADIENT[0]);
+
+const Literal& getGradientColor(int lineIndex, int colIndex, int frame) {
+    // 45-degree diagonal: both lineIndex and colIndex contribute equally
+    return GRADIENT[(lineIndex + colIndex + frame) % GRADIENT_STEPS];
+}
+
+// A run of banner text; gradient coordinates of -1 leave it uncolored
+struct BannerSpan {
+    int line;
+    int column;
+    const char* text;
+};
+
+// Each row is indented two columns; unused trailing spans stay null
+struct BannerRow {
+    BannerSpan spans[5];
+};
+
+const BannerRow BANNER[] = {
+    {{ {0, 0, "╔════════════════════════════════════════════════════════════════════════════════════════════════╗"} }},
+    {{ {0, 0, "║"}, {-1, 0, "                                                                                                "}, {0, 95, "║"} }},
+    {{ {1, 0, "║"}, {-1, 0, "    "}, {1, 4, "████████╗ █████╗ ███████╗██╗  ██╗    ███╗   ███╗ █████╗ ███████╗████████╗███████╗██████╗ "}, {-1, 0, " "}, {1, 95, "  ║"} }},
+    {{ {2, 0, "║"}, {-1, 0, "    "}, {2, 4, "╚══██╔══╝██╔══██╗██╔════╝██║ ██╔╝    ████╗ ████║██╔══██╗██╔════╝╚══██╔══╝██╔════╝██╔══██╗"}, {-1, 0, " "}, {2, 95, "  ║"} }},
+    {{ {3, 0, "║"}, {-1, 0, "       "}, {3, 7, "██║   ███████║███████╗█████╔╝     ██╔████╔██║███████║███████╗   ██║   █████╗  ██████╔╝"}, {-1, 0, " "}, {3, 95, "  ║"} }},
+    {{ {5, 0, "║"}, {-1, 0, "       "}, {5, 7, "██║   ██╔══██║╚════██║██╔═██╗     ██║╚██╔╝██║██╔══██║╚════██║   ██║   ██╔══╝  ██╔══██╗"}, {-1, 0, " "}, {5, 95, "  ║"} }},
+    {{ {6, 0, "║"}, {-1, 0, "       "}, {6, 7, "██║   ██║  ██║███████║██║  ██╗    ██║ ╚═╝ ██║██║  ██║███████║   ██║   ███████╗██║  ██║"}, {-1, 0, " "}, {6, 95, "  ║"} }},
+    {{ {7, 0, "║"}, {-1, 0, "       "}, {7, 7, "╚═╝   ╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝    ╚═╝     ╚═╝╚═╝  ╚═╝╚══════╝   ╚═╝   ╚══════╝╚═╝  ╚═╝"}, {-1, 0, " "}, {7, 95, "  ║"} }},
+    {{ {8, 0, "║"}, {-1, 0, "                                                                                                "}, {8, 95, "║"} }},
+    {{ {9, 0, "║"}, {-1, 0, "                                 "}, {9, 33, "Advanced Task Management System"}, {-1, 0, "                                "}, {9, 95, "║"} }},
+    {{ {10, 0, "║"}, {-1, 0, "                           "}, {10, 27, "Priority Tracking • Undo/Redo • Search & Sort"}, {-1, 0, "                        "}, {10, 95, "║"} }},
+    {{ {11, 0, "║"}, {-1, 0, "                                                                                                "}, {11, 95, "║"} }},
+    {{ {12, 0, "╚════════════════════════════════════════════════════════════════════════════════════════════════╝"} }},
+};
+
+const int BANNER_ROWS = sizeof(BANNER) / sizeof(BANNER[0]) + 2;   // plus the blank rows above and below
+const int BANNER_COLS = 100;
+// The gradient repeats every GRADIENT_STEPS frames, so one extra frame is
+// enough: after the first, frames 1..GRADIENT_STEPS loop seamlessly
+const int BANNER_FRAMES = GRADIENT_STEPS + 1;
+const int BANNER_FRAME_MS = 80;
+const int BANNER_MIN_MS = 1600;   // one full gradient cycle
+
+void appendBannerFrame(string& out, int frame) {
+    out += '\n';
+    for (const BannerRow& row : BANNER) {
+        out += "  ";
+        for (const BannerSpan& span : row.spans) {
+            if (!span.text) break;
+            if (span.line < 0) {
+                out += span.text;
+                continue;
+            }
+            appendLiteral(out, getGradientColor(span.line, span.column, frame));
+            out += span.text;
+            out += RESET;
+        }
+        out += '\n';
+    }
+}
+
+// Every frame is rendered up front as the bytes that turn the previous
+// frame into it, so playing the animation is just writing buffers
+vector<string> renderBannerFrames() {
+    Screen screen(BANNER_ROWS, BANNER_COLS);
+    screen.placeCursor(BANNER_ROWS - 1, 0);
+
+    vector<string> frames;
+    string text;
+    for (int frame = 0; frame < BANNER_FRAMES; ++frame) {
+        text.clear();
+        appendBannerFrame(text, frame);
+        screen.clear();
+        screen.draw(0, 0, text);
+        frames.push_back(screen.diff());
+    }
+    return frames;
+}
+
+// Set by main() once tasks are loaded and the startup work is done
+atomic<bool> startupDone(false);
+
+// Runs on its own thread while main() loads. Frames are paced against the
+// clock rather than by fixed sleeps, and the banner stops once loading is
+// done and it has shown for BANNER_MIN_MS, or as soon as a key is pressed.
+// It writes to stdout directly and never touches cout, which main() has
+// redirected while loading.
+void displayWelcomeBanner() {
+    RawMode raw;
+    vector<string> frames = renderBannerFrames();
+    auto start = chrono::steady_clock::now();
+    auto next = start;
+
+    for (size_t f = 0; ; f = f % GRADIENT_STEPS + 1) {
+        fwrite(frames[f].data(), 1, frames[f].size(), stdout);
+        fflush(stdout);
+
+        if (keyPressed()) {
+            readKey();
+            break;
+        }
+        next += chrono::milliseconds(BANNER_FRAME_MS);
+        if (startupDone && next - start >= chrono::milliseconds(BANNER_MIN_MS)) break;
+        this_thread::sleep_until(next);
+    }
+}
+
+void displayMenu() {
+    cout << "\n";
+    cout << "  ============================= MAIN MENU =============================\n";
+    cout << "  1. [+] Add Task             5. [?] Search Tasks\n";
+    cout << "  2. [=] View Tasks           6. [*] Sort Tasks\n";
+    cout << "  3. [~] Edit Task            7. [<] Undo\n";
+    cout << "  4. [X] Delete Task          8. [>] Redo\n";
+    cout << "  0. [#] Most Urgent          9. [!] Exit\n";
+    cout << "  ====================================================================\n";
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// INPUT HELPER FUNCTIONS
+// ═══════════════════════════════════════════════════════════════════
+
+// False once input ends. Blank lines are skipped, as `cin >> v` did.
+bool tryReadInt(const string& prompt, int& value) {
+    string line;
+    cout << "  " << prompt;
+    while (stdinInput.readLine(line)) {
+        if (line.find_first_not_of(" \t") == string::npos) continue;
+        if (parseInt(line, value)) return true;
+        cout << "  " << RED << "[X]" << RESET << " Invalid number. Please try again.\n";
+        cout << "  " << prompt;
+    }
+    return false;
+}
+
+// 0 once input has ended, which every prompt treats as keep or cancel
+int readInt(const string& prompt) {
+    int v = 0;
+    return tryReadInt(prompt, v) ? v : 0;
+}
+
+string readLine(const string& prompt) {
+    cout << "  " << prompt;
+    string s;
+    stdinInput.readLine(s);
+    return s;
+}
+
+// Menu choices are single digits, so at a terminal one keypress selects;
+// piped input keeps the line-per-answer format
+int readChoice(const string& prompt) {
+    // When input closes, save and exit rather than spin on the menu
+    int choice;
+    if (!inputIsTerminal()) return tryReadInt(prompt, choice) ? choice : 9;
+
+    cout << "  " << prompt << flush;
+    RawMode raw;
+    while (true) {
+        int key = readKey();
+        if (key >= '0' && key <= '9') {
+            cout << (char)key << "\n";
+            return key - '0';
+        }
+        if (key == EOF) {
+            cout << "9\n";
+            return 9;
+        }
+    }
+}
+
+TaskChange taskChange(const Task* before, const Task* after) {
+    TaskChange c;
+    if (before) {
+        c.hadBefore = true;
+        c.before = *before;
+    }
+    if (after) {
+        c.hadAfter = true;
+        c.after = *after;
+    }
+    return c;
+}
+
+void recordChange(TaskChange change) {
+    undoStack.push_back(move(change));
+    if (undoStack.size() > UNDO_LIMIT) undoStack.pop_front();
+    redoStack.clear();
+}
+
+// A merge gave one of our new tasks another id; the history follows it
+void renumberHistory(uint32_t from, uint32_t to) {
+    for (auto* stack : { &undoStack, &redoStack }) {
+        for (auto& c : *stack) {
+            if (c.hadBefore && c.before.id == from) c.before.id = to;
+            if (c.hadAfter && c.after.id == from) c.after.id = to;
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// FILE STORAGE FUNCTIONS
+// ═══════════════════════════════════════════════════════════════════
+
+// tasks.json holds the whole list. One-shot commands and the daemon append
+// single changes to tasks.journal instead of rewriting it; loadTasks replays
+// the journal and the next full save folds it in and removes it.
+//
+// Several processes may share the files. tasks.lock is locked while the
+// files are read (shared) or written (exclusive), never across user input.
+// Every full save bumps the "revision" stamped in tasks.json, so together
+// with the journal's length it tells a writer whether anyone else wrote
+// since it last read; if so, it merges their changes by task id before
+// writing (see mergeConcurrentChanges).
+
+// Priorities are stored as 1 (Low) to 3 (High), the scale the menu asks
+// for. Files and journal entries without "format" 2 come from versions that
+// stored the enum value, 0 to 2, and are read that way.
+const int STORE_FORMAT = 2;
+const int PRIORITY_UNSET = INT_MIN;
+
+int storedPriorityValue(Priority p) {
+    return (int)p + 1;
+}
+
+Priority storedPriority(int v, bool legacy) {
+    if (v == PRIORITY_UNSET) return Priority::Medium;
+    return intToPriority(legacy ? v + 1 : v);
+}
+
+json taskToJson(const Task& t) {
+    return {
+        {"title", t.title},
+        {"completed", t.completed},
+        {"priority", storedPriorityValue(t.priority)},
+        {"dueDate", t.dueDate},
+        {"id", t.id},
+        {"created", t.created}
+    };
+}
+
+Task taskFromJson(const json& item, bool legacy) {
+    Task task;
+    task.title = item.value("title", "");
+    task.completed = item.value("completed", false);
+    task.priority = storedPriority(item.value("priority", PRIORITY_UNSET), legacy);
+    task.dueDate = item.value("dueDate", "");
+    task.id = item.value("id", 0u);
+    task.created = item.value("created", (int64_t)0);
+    return task;
+}
+
+// Contents from byte offset `from` on; false if the file cannot be opened
+bool readWholeFile(const char* path, string& text, size_t from = 0) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    text.clear();
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long size = ftell(f);
+        if (size > (long)from) text.reserve((size_t)size - from);
+    }
+    fseek(f, (long)from, SEEK_SET);
+    char chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) text.append(chunk, n);
+    fclose(f);
+    return true;
+}
+
+size_t fileSize(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : 0;
+    fclose(f);
+    return size > 0 ? (size_t)size : 0;
+}
+
+// Unsigned value of a top-level key in the first bytes of tasks.json, where
+// saveTasks puts the counters (keys are written in sorted order), or 0
+uint64_t storedCounter(const char* key) {
+    FILE* f = fopen("tasks.json", "rb");
+    if (!f) return 0;
+    char head[128];
+    size_t n = fread(head, 1, sizeof(head) - 1, f);
+    fclose(f);
+    head[n] = '\0';
+
+    string quoted = string("\"") + key + "\"";
+    const char* at = strstr(head, quoted.c_str());
+    if (!at) return 0;
+    at += quoted.size();
+    while (*at == ' ' || *at == ':') ++at;
+    return strtoull(at, nullptr, 10);
+}
+
+// Reads the layout saveTasks writes without building a DOM. Anything it
+// does not expect (other value types, non-integer numbers, malformed text)
+// makes it give up so the general parser can decide, which keeps both
+// paths accepting exactly the same files.
+class TaskFileParser {
+public:
+    TaskFileParser(const string& text) : p(text.data()), end(text.data() + text.size()) {}
+
+    bool parse(vector<Task>& tasks, uint32_t& storedNextId, uint64_t& revision) {
+        if (!expect('{')) return false;
+        if (peek() == '}') return true;
+        size_t first = tasks.size();
+        int64_t format = 0;
+        do {
+            string key;
+            if (!readString(key) || !expect(':')) return false;
+            if (key == "tasks") {
+                if (!readTasks(tasks)) return false;
+            } else if (key == "format") {
+                if (!readInteger(format)) return false;
+            } else if (key == "nextId") {
+                int64_t v;
+                if (!readInteger(v) || v < 0 || v > UINT32_MAX) return false;
+                storedNextId = (uint32_t)v;
+            } else if (key == "revision") {
+                int64_t v;
+                if (!readInteger(v) || v < 0) return false;
+                revision = (uint64_t)v;
+            } else if (!skipValue(0)) {
+                return false;
+            }
+        } while (accept(','));
+        if (!expect('}')) return false;
+
+        // readTask leaves the raw stored value in priority until the
+        // format is known, which may come after the tasks
+        for (size_t i = first; i < tasks.size(); ++i) {
+            tasks[i].priority = storedPriority((int)tasks[i].priority, format < STORE_FORMAT);
+        }
+        return true;
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+    }
+
+    char peek() {
+        skipSpace();
+        return p < end ? *p : '\0';
+    }
+
+    bool accept(char c) {
+        if (peek() != c) return false;
+        ++p;
+        return true;
+    }
+
+    bool expect(char c) {
+        return accept(c);
+    }
+
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if ((size_t)(end - p) < n || memcmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    bool readBool(bool& v) {
+        skipSpace();
+        if (literal("true")) v = true;
+        else if (literal("false")) v = false;
+        else return false;
+        return true;
+    }
+
+    bool readInteger(int64_t& v) {
+        skipSpace();
+        bool negative = p < end && *p == '-';
+        if (negative) ++p;
+        if (p == end || *p < '0' || *p > '9') return false;
+        if (*p == '0' && p + 1 < end && p[1] >= '0' && p[1] <= '9') return false;
+        uint64_t n = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (n > (uint64_t)INT64_MAX / 10) return false;
+            n = n * 10 + (uint64_t)(*p++ - '0');
+        }
+        if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) return false;
+        if (n > (uint64_t)INT64_MAX) return false;
+        v = negative ? -(int64_t)n : (int64_t)n;
+        return true;
+    }
+
+    bool readHex4(uint32_t& cp) {
+        if (end - p < 4) return false;
+        cp = 0;
+        for (int k = 0; k < 4; ++k) {
+            char c = *p++;
+            cp <<= 4;
+            if (c >= '0' && c <= '9') cp |= (uint32_t)(c - '0');
+            else if (c >= 'a' && c <= 'f') cp |= (uint32_t)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') cp |= (uint32_t)(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    // Length of the well-formed UTF-8 sequence at p, 0 if there is none
+    size_t utf8Length() {
+        unsigned char b0 = (unsigned char)p[0];
+        size_t n;
+        unsigned char lo = 0x80, hi = 0xBF;
+        if (b0 >= 0xC2 && b0 <= 0xDF) n = 2;
+        else if (b0 >= 0xE0 && b0 <= 0xEF) {
+            n = 3;
+            if (b0 == 0xE0) lo = 0xA0;
+            if (b0 == 0xED) hi = 0x9F;
+        } else if (b0 >= 0xF0 && b0 <= 0xF4) {
+            n = 4;
+            if (b0 == 0xF0) lo = 0x90;
+            if (b0 == 0xF4) hi = 0x8F;
+        } else {
+            return 0;
+        }
+        if ((size_t)(end - p) < n) return 0;
+        unsigned char b1 = (unsigned char)p[1];
+        if (b1 < lo || b1 > hi) return 0;
+        for (size_t k = 2; k < n; ++k) {
+            if (((unsigned char)p[k] & 0xC0) != 0x80) return 0;
+        }
+        return n;
+    }
+
+    bool readString(string& out) {
+        if (!expect('"')) return false;
+        out.clear();
+        while (true) {
+            const char* run = p;
+            while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20 && (unsigned char)*p < 0x80) ++p;
+            out.append(run, p);
+            if (p == end) return false;
+
+            unsigned char c = (unsigned char)*p;
+            if (c == '"') {
+                ++p;
+                return true;
+            }
+            if (c < 0x20) return false;
+            if (c >= 0x80) {
+                size_t n = utf8Length();
+                if (n == 0) return false;
+                out.append(p, n);
+                p += n;
+                continue;
+            }
+
+            if (++p == end) return false;
+            char e = *p++;
+            switch (e) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!readHex4(cp)) return false;
+                    if (cp >= 0xDC00 && cp <= 0xDFFF) return false;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        uint32_t low;
+                        if (!literal("\\u") || !readHex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+    }
+
+    // Values under keys we do not use; only the shapes saveTasks could
+    // have written are accepted
+    bool skipValue(int depth) {
+        if (depth > 64) return false;
+        char c = peek();
+        string s;
+        int64_t n;
+        bool b;
+        if (c == '"') return readString(s);
+        if (c == 't' || c == 'f') return readBool(b);
+        if (c == 'n') return literal("null");
+        if (c == '[' || c == '{') {
+            ++p;
+            char close = c == '[' ? ']' : '}';
+            if (accept(close)) return true;
+            do {
+                if (c == '{' && (!readString(s) || !expect(':'))) return false;
+                if (!skipValue(depth + 1)) return false;
+            } while (accept(','));
+            return expect(close);
+        }
+        return readInteger(n);
+    }
+
+    bool readTask(Task& task) {
+        if (!expect('{')) return false;
+        int64_t priority = PRIORITY_UNSET, id = 0, created = 0;
+        if (!accept('}')) {
+            string key;
+            do {
+                if (!readString(key) || !expect(':')) return false;
+                bool ok;
+                if (key == "title") ok = readString(task.title);
+                else if (key == "completed") ok = readBool(task.completed);
+                else if (key == "priority") ok = readInteger(priority) && priority >= INT_MIN && priority <= INT_MAX;
+                else if (key == "dueDate") ok = readString(task.dueDate);
+                else if (key == "id") ok = readInteger(id) && id >= 0 && id <= UINT32_MAX;
+                else if (key == "created") ok = readInteger(created);
+                else ok = skipValue(0);
+                if (!ok) return false;
+            } while (accept(','));
+            if (!expect('}')) return false;
+        }
+        task.priority = (Priority)priority;   // decoded by parse
+        task.id = (uint32_t)id;
+        task.created = created;
+        return true;
+    }
+
+    bool readTasks(vector<Task>& tasks) {
+        if (!expect('[')) return false;
+        if (accept(']')) return true;
+        do {
+            Task task;
+            if (!readTask(task)) return false;
+            if (!task.title.empty()) tasks.push_back(move(task));
+        } while (accept(','));
+        return expect(']');
+    }
+};
+
+// Applies journal entries: "add" and "edit" carry the whole task, "done"
+// and "delete" just its id. A torn last line from an interrupted append is
+// ignored.
+void applyJournalText(vector<Task>& tasks, const string& text) {
+    unordered_map<uint32_t, size_t> positions;
+    bool indexed = false, removed = false;
+    auto find = [&](uint32_t id) -> Task* {
+        if (!indexed) {
+            for (size_t i = 0; i < tasks.size(); ++i) positions[tasks[i].id] = i;
+            indexed = true;
+        }
+        auto it = positions.find(id);
+        return it == positions.end() ? nullptr : &tasks[it->second];
+    };
+
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t newline = text.find('\n', start);
+        if (newline == string::npos) newline = text.size();
+        json entry;
+        try {
+            entry = json::parse(text.begin() + start, text.begin() + newline);
+        } catch (...) {
+            start = newline + 1;
+            continue;
+        }
+        start = newline + 1;
+
+        string op = entry.value("op", "");
+        uint32_t id = entry.value("id", 0u);
+        if (op == "add") {
+            Task task = taskFromJson(entry, !entry.contains("format"));
+            if (task.title.empty()) continue;
+            if (indexed) positions[task.id] = tasks.size();
+            tasks.push_back(move(task));
+        } else if (Task* t = find(id)) {
+            if (op == "edit") {
+                Task task = taskFromJson(entry, !entry.contains("format"));
+                if (!task.title.empty()) *t = move(task);
+            } else if (op == "done") {
+                t->completed = true;
+            } else if (op == "delete") {
+                t->title.clear();   // dropped below, keeping positions valid meanwhile
+                positions.erase(id);
+                removed = true;
+            }
+        }
+    }
+
+    if (removed) {
+        tasks.erase(remove_if(tasks.begin(), tasks.end(), [](const Task& t) { return t.title.empty(); }), tasks.end());
+    }
+}
+
+// Appends lines that are already formatted, each ending in "\n". The
+// caller holds the store lock.
+bool appendJournalText(const string& lines) {
+    // A writer that died mid-append leaves half a line; start a fresh one
+    bool torn = false;
+    if (FILE* f = fopen("tasks.journal", "rb")) {
+        torn = fseek(f, -1, SEEK_END) == 0 && fgetc(f) != '\n';
+        fclose(f);
+    }
+    ofstream file("tasks.journal", ios::app | ios::binary);
+    if (!file.is_open()) return false;
+    if (torn) file << '\n';
+    file << lines;
+    return (bool)file;
+}
+
+bool appendJournal(const json& entry) {
+    return appendJournalText(entry.dump() + '\n');
+}
+
+// Advisory lock on tasks.lock for as long as the object lives. Locks from
+// one process do not nest, so only the outermost storage call takes one.
+class StoreLock {
+public:
+    explicit StoreLock(bool exclusive) {
+#ifdef _WIN32
+        handle_ = CreateFileA("tasks.lock", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle_ != INVALID_HANDLE_VALUE) {
+            OVERLAPPED whole = {};
+            LockFileEx(handle_, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, MAXDWORD, MAXDWORD, &whole);
+        }
+#else
+        fd_ = open("tasks.lock", O_RDWR | O_CREAT, 0644);
+        if (fd_ >= 0) {
+            while (flock(fd_, exclusive ? LOCK_EX : LOCK_SH) < 0 && errno == EINTR) {}
+        }
+#endif
+    }
+
+    // Closing the handle releases the lock
+    ~StoreLock() {
+#ifdef _WIN32
+        if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+#else
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    StoreLock(const StoreLock&) = delete;
+    StoreLock& operator=(const StoreLock&) = delete;
+
+private:
+#ifdef _WIN32
+    HANDLE handle_;
+#else
+    int fd_;
+#endif
+};
+
+struct StoreStamp {
+    uint64_t revision = 0;
+    size_t journalSize = 0;
+};
+
+bool operator==(const StoreStamp& a, const StoreStamp& b) {
+    return a.revision == b.revision && a.journalSize == b.journalSize;
+}
+
+// The files as this process last read or wrote them: their stamp and a
+// hash of every task, so its own changes since can be told apart by id
+StoreStamp syncedStamp;
+unordered_map<uint32_t, uint64_t> syncedHashes;
+
+StoreStamp readStoreStamp() {
+    StoreStamp s;
+    s.revision = storedCounter("revision");
+    s.journalSize = fileSize("tasks.journal");
+    return s;
+}
+
+uint64_t taskHash(const Task& t) {
+    hash<string> h;
+    uint64_t v = h(t.title);
+    v = v * 1099511628211ULL ^ h(t.dueDate);
+    v = v * 1099511628211ULL ^ (uint64_t)t.created;
+    v = v * 1099511628211ULL ^ ((uint64_t)t.priority << 1 | (t.completed ? 1 : 0));
+    return v;
+}
+
+void rememberSynced(const vector<Task>& tasks) {
+    syncedHashes.clear();
+    syncedHashes.reserve(tasks.size());
+    for (const auto& t : tasks) syncedHashes[t.id] = taskHash(t);
+}
+
+// Reads tasks.json and replays the journal. False when tasks.json is not
+// valid JSON. The caller holds the store lock.
+bool readStoreFiles(vector<Task>& tasks, uint32_t& storedNextId, StoreStamp& stamp) {
+    string text;
+    storedNextId = 0;
+    stamp = StoreStamp();
+    if (readWholeFile("tasks.json", text)) {
+        if (!TaskFileParser(text).parse(tasks, storedNextId, stamp.revision)) {
+            tasks.clear();
+            storedNextId = 0;
+            stamp.revision = 0;
+
+            json j;
+            istringstream in(text);
+            try {
+                in >> j;
+            } catch (...) {
+                return false;
+            }
+
+            bool legacy = !(j.contains("format") && j["format"].is_number_integer() && j["format"].get<int>() >= STORE_FORMAT);
+            if (j.contains("tasks") && j["tasks"].is_array()) {
+                for (const auto& item : j["tasks"]) {
+                    Task task = taskFromJson(item, legacy);
+                    if (!task.title.empty()) {
+                        tasks.push_back(task);
+                    }
+                }
+            }
+            if (j.contains("nextId") && j["nextId"].is_number_unsigned()) {
+                storedNextId = j["nextId"].get<uint32_t>();
+            }
+            if (j.contains("revision") && j["revision"].is_number_unsigned()) {
+                stamp.revision = j["revision"].get<uint64_t>();
+            }
+        }
+    }
+    if (readWholeFile("tasks.journal", text)) {
+        applyJournalText(tasks, text);
+        stamp.journalSize = text.size();
+    }
+    return true;
+}
+
+// Files from older versions have no ids; duplicates get fresh ones too.
+// The stored counter keeps ids of deleted tasks from being reused. True if
+// any task was given an id.
+bool normalizeIds(vector<Task>& tasks, uint32_t storedNextId) {
+    unordered_set<uint32_t> seen;
+    bool assigned = false;
+    nextTaskId = max(nextTaskId, storedNextId);
+    for (const auto& t : tasks) nextTaskId = max(nextTaskId, t.id + 1);
+    for (auto& t : tasks) {
+        if (t.id == 0 || !seen.insert(t.id).second) {
+            t.id = nextTaskId++;
+            seen.insert(t.id);
+            assigned = true;
+        }
+    }
+    return assigned;
+}
+
+// Brings in what other processes wrote since this one last read or wrote
+// the files, keeping its own changes since then on top: a task changed here
+// keeps this version, tasks added on both sides are all kept (renumbering
+// ours if the ids clash), and a delete on either side wins. When tasks.json
+// has not been rewritten only the journal entries appended since are read.
+// The caller holds the store lock and writes the result, or has no changes
+// of its own. Returns whether anything was merged.
+bool mergeConcurrentChanges(vector<Task>& tasks) {
+    StoreStamp disk = readStoreStamp();
+    if (disk == syncedStamp) return false;
+
+    // This process's changes since the last sync
+    vector<Task> changed;
+    vector<bool> addedHere;
+    unordered_set<uint32_t> present;
+    for (const auto& t : tasks) {
+        present.insert(t.id);
+        auto it = syncedHashes.find(t.id);
+        if (it == syncedHashes.end() || it->second != taskHash(t)) {
+            changed.push_back(t);
+            addedHere.push_back(it == syncedHashes.end());
+        }
+    }
+    vector<uint32_t> deleted;
+    for (const auto& h : syncedHashes) {
+        if (!present.count(h.first)) deleted.push_back(h.first);
+    }
+
+    vector<Task> merged;
+    uint32_t storedNextId = (uint32_t)storedCounter("nextId");
+    if (disk.revision == syncedStamp.revision && disk.journalSize > syncedStamp.journalSize) {
+        // Only appended to: apply the new entries to this list minus its own
+        // additions; its edits and deletes are put back below anyway
+        string delta;
+        if (!readWholeFile("tasks.journal", delta, syncedStamp.journalSize)) return false;
+        for (auto& t : tasks) {
+            if (syncedHashes.count(t.id)) merged.push_back(move(t));
+        }
+        applyJournalText(merged, delta);
+    } else {
+        StoreStamp read;
+        if (!readStoreFiles(merged, storedNextId, read)) {
+            // Unreadable: keep ours, and the next save replaces the file
+            syncedStamp = disk;
+            return false;
+        }
+        disk = read;
+    }
+
+    // An old or hand-edited file may lack ids or repeat them; number its
+    // tasks as loadTasks does before matching by id
+    normalizeIds(merged, storedNextId);
+    unordered_map<uint32_t, size_t> positions;
+    for (size_t i = 0; i < merged.size(); ++i) positions[merged[i].id] = i;
+
+    bool removed = false;
+    for (uint32_t id : deleted) {
+        auto it = positions.find(id);
+        if (it == positions.end()) continue;
+        merged[it->second].title.clear();
+        positions.erase(it);
+        removed = true;
+    }
+    for (size_t k = 0; k < changed.size(); ++k) {
+        Task& t = changed[k];
+        auto it = positions.find(t.id);
+        if (addedHere[k]) {
+            if (it != positions.end()) {
+                renumberHistory(t.id, nextTaskId);
+                t.id = nextTaskId++;
+            }
+            merged.push_back(move(t));
+        } else if (it != positions.end()) {
+            merged[it->second] = move(t);
+        }
+    }
+    if (removed) {
+        merged.erase(remove_if(merged.begin(), merged.end(), [](const Task& t) { return t.title.empty(); }), merged.end());
+    }
+
+    tasks = move(merged);
+    syncedStamp = disk;
+    touchStore();   // everything derived rebuilds, as after a batch
+    return true;
+}
+
+// For readers holding no unsaved changes: picks up other processes' writes
+void syncWithStore(vector<Task>& tasks) {
+    StoreLock lock(false);
+    if (mergeConcurrentChanges(tasks)) rememberSynced(tasks);
+}
+
+bool replaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+// Writes the whole list through a temporary file, so readers never see a
+// partial one, and folds the journal in. The caller holds the store lock.
+void writeTasksLocked(const vector<Task>& tasks) {
+    json j;
+    j["format"] = STORE_FORMAT;
+    j["nextId"] = nextTaskId;
+    j["revision"] = syncedStamp.revision + 1;
+    j["tasks"] = json::array();
+
+    for (const auto& t : tasks) {
+        j["tasks"].push_back(taskToJson(t));
+    }
+
+    ofstream file("tasks.json.tmp");
+    if (!file.is_open()) return;
+    file << j.dump(4);
+    file.close();
+    if (!file || !replaceFile("tasks.json.tmp", "tasks.json")) {
+        remove("tasks.json.tmp");
+        return;
+    }
+    remove("tasks.journal");
+    syncedStamp.revision += 1;
+    syncedStamp.journalSize = 0;
+    rememberSynced(tasks);
+}
+
+void saveTasks(vector<Task>& tasks) {
+    StoreLock lock(true);
+    mergeConcurrentChanges(tasks);
+    writeTasksLocked(tasks);
+}
+
+void loadTasks(vector<Task>& tasks) {
+    uint32_t storedNextId;
+    {
+        StoreLock lock(false);
+        if (!readStoreFiles(tasks, storedNextId, syncedStamp)) {
+            cout << "  " << YELLOW << "[!]" << RESET << " Invalid JSON file. Starting fresh.\n";
+            tasks.clear();
+            return;
+        }
+    }
+
+    bool assigned = normalizeIds(tasks, storedNextId);
+    rememberSynced(tasks);
+    touchStore();
+
+    // Ids given here exist only in memory until written, and the next load
+    // could hand out different ones; save them, and the counter a file
+    // from before it was stored lacks, so every reader agrees
+    if (assigned || (storedNextId == 0 && !tasks.empty())) saveTasks(tasks);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// UTILITY FUNCTIONS
+// ═══════════════════════════════════════════════════════════════════
+
+bool taskExists(const vector<Task>& tasks, const string& title) {
+    for (const auto& t : tasks) {
+        if (t.title == title) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// FUZZY SEARCH
+// ═══════════════════════════════════════════════════════════════════
+
+const int FUZZY_MAX_PATTERN = 64;   // bitap state must fit one machine word
+const int FUZZY_MAX_ERRORS = 3;
+const size_t FUZZY_TOP_K = 20;
+
+struct FuzzyMatcher {
+    uint64_t masks[256];
+    int length = 0;
+    int maxErrors = 0;
+};
+
+struct FuzzyHit {
+    size_t index;   // position in the task list
+    int errors;     // edit distance of the best approximate match
+    int endPos;     // where in the title that match ends
+};
+
+// Best first: fewer errors, then earlier in the title, then list order
+bool fuzzyBetter(const FuzzyHit& a, const FuzzyHit& b) {
+    if (a.errors != b.errors) return a.errors < b.errors;
+    if (a.endPos != b.endPos) return a.endPos < b.endPos;
+    return a.index < b.index;
+}
+
+// Allowed typos grow with the query so short words stay precise
+int fuzzyErrorBudget(int length) {
+    if (length <= 3) return 0;
+    if (length <= 5) return 1;
+    if (length <= 9) return 2;
+    return FUZZY_MAX_ERRORS;
+}
+
+FuzzyMatcher buildFuzzyMatcher(const string& pattern) {
+    FuzzyMatcher fm;
+    fill(begin(fm.masks), end(fm.masks), 0);
+    fm.length = (int)min(pattern.size(), (size_t)FUZZY_MAX_PATTERN);
+    fm.maxErrors = fuzzyErrorBudget(fm.length);
+
+    // Letters match either case, so titles never need lowercasing
+    for (int i = 0; i < fm.length; ++i) {
+        unsigned char c = (unsigned char)pattern[i];
+        fm.masks[c] |= 1ULL << i;
+        fm.masks[(unsigned char)tolower(c)] |= 1ULL << i;
+        fm.masks[(unsigned char)toupper(c)] |= 1ULL << i;
+    }
+    return fm;
+}
+
+// Bitap (Wu-Manber) approximate substring match: returns the fewest
+// errors <= limit with which the pattern occurs in text, or -1.
+int fuzzyMatch(const FuzzyMatcher& fm, const string& text, int limit, int& endPos) {
+    if (fm.length == 0) return -1;
+    limit = min(limit, min(fm.maxErrors, fm.length - 1));
+
+    uint64_t R[FUZZY_MAX_ERRORS + 1];
+    for (int d = 0; d <= limit; ++d) {
+        R[d] = (1ULL << d) - 1;  // d leading pattern chars deleted
+    }
+
+    const uint64_t accept = 1ULL << (fm.length - 1);
+    int best = -1;
+
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        uint64_t mask = fm.masks[(unsigned char)text[pos]];
+        uint64_t prev = R[0];
+        R[0] = ((R[0] << 1) | 1) & mask;
+
+        for (int d = 1; d <= limit; ++d) {
+            uint64_t old = R[d];
+            R[d] = (((old << 1) | 1) & mask)   // match
+                 | ((prev << 1) | 1)           // substitution
+                 | prev                        // extra char in title
+                 | ((R[d - 1] << 1) | 1);      // char missing from title
+            prev = old;
+        }
+
+        for (int d = 0; d <= limit; ++d) {
+            if (R[d] & accept) {
+                best = d;
+                endPos = (int)pos;
+                limit = d - 1;  // from here on only strictly better matches count
+                break;
+            }
+        }
+        if (best == 0) break;
+    }
+    return best;
+}
+
+// Ranks every title against the query and keeps the best topK in a
+// bounded max-heap, so the cost stays O(n) regardless of the hit count.
+vector<FuzzyHit> fuzzySearch(const vector<Task>& tasks, const string& query, size_t topK) {
+    FuzzyMatcher fm = buildFuzzyMatcher(query);
+    priority_queue<FuzzyHit, vector<FuzzyHit>, bool (*)(const FuzzyHit&, const FuzzyHit&)> heap(fuzzyBetter);
+
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        // Once the heap is full, titles worse than its weakest entry are pruned early
+        int limit = heap.size() < topK ? fm.maxErrors : heap.top().errors;
+        int endPos = 0;
+        int errors = fuzzyMatch(fm, tasks[i].title, limit, endPos);
+        if (errors < 0) continue;
+
+        FuzzyHit hit = {i, errors, endPos};
+        if (heap.size() < topK) {
+            heap.push(hit);
+        } else if (fuzzyBetter(hit, heap.top())) {
+            heap.pop();
+            heap.push(hit);
+        }
+    }
+
+    vector<FuzzyHit> hits;
+    hits.reserve(heap.size());
+    while (!heap.empty()) {
+        hits.push_back(heap.top());
+        heap.pop();
+    }
+    reverse(hits.begin(), hits.end());
+    return hits;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// TASK INDEXES
+// ═══════════════════════════════════════════════════════════════════
+
+// Secondary structures over the task list used by the query planner.
+// Built lazily on the first query after any change to the list.
+struct TaskIndex {
+    uint64_t version = 0;                  // storeVersion this was built at
+    vector<uint32_t> byPriority[3];        // task positions per Priority
+    vector<uint64_t> doneBits;             // bit i set = task i completed
+    size_t doneCount = 0;
+    vector<uint32_t> byDue;                // positions with a due date, ordered by date
+    map<string, vector<uint32_t>> words;   // lowercase title word -> ascending positions
+};
+
+TaskIndex taskIndex;
+
+bool isWordChar(unsigned char c) {
+    return isalnum(c) || c >= 0x80;  // keep UTF-8 sequences inside words
+}
+
+string toLower(string s) {
+    for (auto& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+// Needle must already be lowercase
+bool containsIgnoreCase(const string& text, const string& needle) {
+    if (needle.size() > text.size()) return false;
+    for (size_t start = 0; start + needle.size() <= text.size(); ++start) {
+        size_t k = 0;
+        while (k < needle.size() && tolower((unsigned char)text[start + k]) == (unsigned char)needle[k]) ++k;
+        if (k == needle.size()) return true;
+    }
+    return false;
+}
+
+vector<string> titleWords(const string& title) {
+    vector<string> out;
+    string word;
+    for (char c : title) {
+        if (isWordChar((unsigned char)c)) {
+            word += (char)tolower((unsigned char)c);
+        } else if (!word.empty()) {
+            out.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) out.push_back(word);
+    return out;
+}
+
+const TaskIndex& ensureTaskIndex(const vector<Task>& tasks) {
+    if (taskIndex.version == storeVersion) return taskIndex;
+
+    TaskIndex idx;
+    idx.doneBits.assign((tasks.size() + 63) / 64, 0);
+
+    for (uint32_t i = 0; i < (uint32_t)tasks.size(); ++i) {
+        const Task& t = tasks[i];
+        idx.byPriority[(int)t.priority].push_back(i);
+        if (t.completed) {
+            idx.doneBits[i / 64] |= 1ULL << (i % 64);
+            ++idx.doneCount;
+        }
+        if (!t.dueDate.empty()) idx.byDue.push_back(i);
+        for (const auto& w : titleWords(t.title)) {
+            vector<uint32_t>& postings = idx.words[w];
+            if (postings.empty() || postings.back() != i) postings.push_back(i);
+        }
+    }
+
+    stable_sort(idx.byDue.begin(), idx.byDue.end(), [&](uint32_t a, uint32_t b) {
+        return tasks[a].dueDate < tasks[b].dueDate;
+    });
+
+    idx.version = storeVersion;
+    taskIndex = move(idx);
+    return taskIndex;
+}
+
+// Keeps the index current when a task is appended or edited in place, so a
+// long-running process does not rebuild it after every change. Removals
+// shift positions and still rebuild.
+void sortedInsert(vector<uint32_t>& v, uint32_t pos) {
+    v.insert(lower_bound(v.begin(), v.end(), pos), pos);
+}
+
+void sortedErase(vector<uint32_t>& v, uint32_t pos) {
+    auto it = lower_bound(v.begin(), v.end(), pos);
+    if (it != v.end() && *it == pos) v.erase(it);
+}
+
+void setDoneBit(TaskIndex& idx, uint32_t pos, bool done) {
+    if (idx.doneBits.size() <= pos / 64) idx.doneBits.resize(pos / 64 + 1, 0);
+    uint64_t bit = 1ULL << (pos % 64);
+    bool was = (idx.doneBits[pos / 64] & bit) != 0;
+    if (was == done) return;
+    idx.doneBits[pos / 64] ^= bit;
+    if (done) ++idx.doneCount;
+    else --idx.doneCount;
+}
+
+void dueIndexInsert(TaskIndex& idx, const vector<Task>& tasks, uint32_t pos) {
+    if (tasks[pos].dueDate.empty()) return;
+    // Equal dates stay in position order, as the stable sort leaves them
+    auto it = upper_bound(idx.byDue.begin(), idx.byDue.end(), pos, [&](uint32_t p, uint32_t q) {
+        if (tasks[p].dueDate != tasks[q].dueDate) return tasks[p].dueDate < tasks[q].dueDate;
+        return p < q;
+    });
+    idx.byDue.insert(it, pos);
+}
+
+void taskIndexAdd(const vector<Task>& tasks, uint32_t pos) {
+    const Task& t = tasks[pos];
+    taskIndex.byPriority[(int)t.priority].push_back(pos);
+    setDoneBit(taskIndex, pos, t.completed);
+    dueIndexInsert(taskIndex, tasks, pos);
+    for (const auto& w : titleWords(t.title)) {
+        vector<uint32_t>& postings = taskIndex.words[w];
+        if (postings.empty() || postings.back() != pos) postings.push_back(pos);
+    }
+}
+
+void taskIndexChange(const vector<Task>& tasks, uint32_t pos, const Task& before) {
+    const Task& t = tasks[pos];
+    if (t.priority != before.priority) {
+        sortedErase(taskIndex.byPriority[(int)before.priority], pos);
+        sortedInsert(taskIndex.byPriority[(int)t.priority], pos);
+    }
+    setDoneBit(taskIndex, pos, t.completed);
+    if (t.dueDate != before.dueDate) {
+        taskIndex.byDue.erase(remove(taskIndex.byDue.begin(), taskIndex.byDue.end(), pos), taskIndex.byDue.end());
+        dueIndexInsert(taskIndex, tasks, pos);
+    }
+    if (t.title != before.title) {
+        for (const auto& w : titleWords(before.title)) {
+            auto it = taskIndex.words.find(w);
+            if (it == taskIndex.words.end()) continue;
+            sortedErase(it->second, pos);
+            if (it->second.empty()) taskIndex.words.erase(it);
+        }
+        for (const auto& w : titleWords(t.title)) {
+            vector<uint32_t>& postings = taskIndex.words[w];
+            auto at = lower_bound(postings.begin(), postings.end(), pos);
+            if (at == postings.end() || *at != pos) postings.insert(at, pos);
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// QUERY LANGUAGE
+// ═══════════════════════════════════════════════════════════════════
+//
+//   priority:H done:no due<2026-11-01 "budget"
+//
+// Terms are ANDed; OR, NOT / -term and parentheses are also accepted.
+// Fields: priority:(H|M|L), done:(yes|no), due:(DATE|none|any) and
+// due<, due<=, due>, due>= DATE. Any other word or "quoted phrase"
+// matches the start of a word in the title, ignoring case.
+
+enum class QueryOp { And, Or, Not, Priority, Done, Due, Text };
+
+struct QueryNode {
+    QueryOp op = QueryOp::And;
+    Priority priority = Priority::Medium;
+    bool done = false;
+    string cmp;       // Due: "<", "<=", ">", ">=", "=", "none" or "any"
+    string value;     // Due: YYYY-MM-DD, Text: lowercase phrase
+    vector<QueryNode> children;
+};
+
+struct QueryToken {
+    string text;
+    bool quoted;
+};
+
+// Both take lowercase text
+bool parsePriorityName(const string& value, Priority& p) {
+    if (value == "h" || value == "high" || value == "3") p = Priority::High;
+    else if (value == "m" || value == "medium" || value == "2") p = Priority::Medium;
+    else if (value == "l" || value == "low" || value == "1") p = Priority::Low;
+    else return false;
+    return true;
+}
+
+bool parseYesNo(const string& value, bool& yes) {
+    if (value == "yes" || value == "y" || value == "true") yes = true;
+    else if (value == "no" || value == "n" || value == "false") yes = false;
+    else return false;
+    return true;
+}
+
+bool isDate(const string& s) {
+    if (s.size() != 10 || s[4] != '-' || s[7] != '-') return false;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (i != 4 && i != 7 && !isdigit((unsigned char)s[i])) return false;
+    }
+    int y = stoi(s.substr(0, 4)), m = stoi(s.substr(5, 2)), d = stoi(s.substr(8, 2));
+    static const int monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (m < 1 || m > 12 || d < 1) return false;
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return d <= monthDays[m - 1] + (m == 2 && leap ? 1 : 0);
+}
+
+struct QueryParser {
+    vector<QueryToken> tokens;
+    size_t pos = 0;
+    string error;
+
+    bool tokenize(const string& q) {
+        size_t i = 0;
+        while (i < q.size()) {
+            char c = q[i];
+            if (isspace((unsigned char)c)) {
+                ++i;
+            } else if (c == '(' || c == ')') {
+                tokens.push_back({string(1, c), false});
+                ++i;
+            } else if (c == '"') {
+                size_t close = q.find('"', i + 1);
+                if (close == string::npos) {
+                    error = "Unterminated quote";
+                    return false;
+                }
+                tokens.push_back({q.substr(i + 1, close - i - 1), true});
+                i = close + 1;
+            } else {
+                size_t start = i;
+                while (i < q.size() && !isspace((unsigned char)q[i]) && q[i] != '(' && q[i] != ')' && q[i] != '"') ++i;
+                tokens.push_back({q.substr(start, i - start), false});
+            }
+        }
+        return true;
+    }
+
+    bool atKeyword(const char* kw) const {
+        return pos < tokens.size() && !tokens[pos].quoted && tokens[pos].text == kw;
+    }
+
+    bool parseOr(QueryNode& out) {
+        QueryNode first;
+        if (!parseAnd(first)) return false;
+        if (!atKeyword("OR")) {
+            out = move(first);
+            return true;
+        }
+        out = QueryNode();
+        out.op = QueryOp::Or;
+        out.children.push_back(move(first));
+        while (atKeyword("OR")) {
+            ++pos;
+            QueryNode next;
+            if (!parseAnd(next)) return false;
+            out.children.push_back(move(next));
+        }
+        return true;
+    }
+
+    bool parseAnd(QueryNode& out) {
+        out = QueryNode();
+        out.op = QueryOp::And;
+        while (pos < tokens.size() && !atKeyword(")") && !atKeyword("OR")) {
+            if (atKeyword("AND")) {
+                ++pos;
+                continue;
+            }
+            QueryNode child;
+            if (!parseUnary(child)) return false;
+            // Flatten nested ANDs so the planner sees every conjunct
+            if (child.op == QueryOp::And) {
+                for (auto& c : child.children) out.children.push_back(move(c));
+            } else {
+                out.children.push_back(move(child));
+            }
+        }
+        if (out.children.empty()) {
+            error = "Expected a search term";
+            return false;
+        }
+        if (out.children.size() == 1) {
+            QueryNode only = move(out.children[0]);
+            out = move(only);
+        }
+        return true;
+    }
+
+    bool parseUnary(QueryNode& out) {
+        if (atKeyword("NOT")) {
+            ++pos;
+            if (pos >= tokens.size() || atKeyword(")") || atKeyword("OR")) {
+                error = "Expected a search term after NOT";
+                return false;
+            }
+            out = QueryNode();
+            out.op = QueryOp::Not;
+            out.children.resize(1);
+            return parseUnary(out.children[0]);
+        }
+        if (atKeyword("(")) {
+            ++pos;
+            if (!parseOr(out)) return false;
+            if (!atKeyword(")")) {
+                error = "Missing closing parenthesis";
+                return false;
+            }
+            ++pos;
+            return true;
+        }
+        const QueryToken& tok = tokens[pos++];
+        if (tok.quoted) return makeText(tok.text, out);
+        return parseTerm(tok.text, out);
+    }
+
+    bool makeText(const string& text, QueryNode& out) {
+        if (text.empty()) {
+            error = "Empty phrase";
+            return false;
+        }
+        out = QueryNode();
+        out.op = QueryOp::Text;
+        out.value = toLower(text);
+        return true;
+    }
+
+    bool parseTerm(const string& term, QueryNode& out) {
+        if (term.size() > 1 && term[0] == '-') {
+            out = QueryNode();
+            out.op = QueryOp::Not;
+            out.children.resize(1);
+            return parseTerm(term.substr(1), out.children[0]);
+        }
+
+        string lower = toLower(term);
+        size_t sep = lower.find_first_of(":<>=");
+        if (sep == string::npos) return makeText(term, out);
+
+        string field = lower.substr(0, sep);
+        string op = lower.substr(sep, 1);
+        if (op != ":" && sep + 1 < lower.size() && lower[sep + 1] == '=') op += "=";
+        string value = lower.substr(sep + op.size());
+
+        out = QueryNode();
+        if (field == "priority" || field == "p") {
+            out.op = QueryOp::Priority;
+            if (op != ":") return fail("priority only supports ':'");
+            if (!parsePriorityName(value, out.priority)) return fail("Unknown priority '" + value + "' (use H, M or L)");
+            return true;
+        }
+        if (field == "done") {
+            out.op = QueryOp::Done;
+            if (op != ":") return fail("done only supports ':'");
+            if (!parseYesNo(value, out.done)) return fail("Unknown done value '" + value + "' (use yes or no)");
+            return true;
+        }
+        if (field == "due") {
+            out.op = QueryOp::Due;
+            if (op == ":" && (value == "none" || value == "any")) {
+                out.cmp = value;
+                return true;
+            }
+            out.cmp = (op == ":") ? "=" : op;
+            out.value = value;
+            if (!isDate(value)) return fail("Invalid date '" + value + "' (expected YYYY-MM-DD)");
+            return true;
+        }
+        return makeText(term, out);
+    }
+
+    bool fail(const string& msg) {
+        error = msg;
+        return false;
+    }
+};
+
+bool parseQuery(const string& text, QueryNode& out, string& error) {
+    QueryParser p;
+    if (!p.tokenize(text) || !p.parseOr(out)) {
+        error = p.error;
+        return false;
+    }
+    if (p.pos != p.tokens.size()) {
+        error = "Unexpected '" + p.tokens[p.pos].text + "'";
+        return false;
+    }
+    return true;
+}
+
+string describeQuery(const QueryNode& q) {
+    switch (q.op) {
+        case QueryOp::Priority: return "priority:" + priorityToString(q.priority);
+        case QueryOp::Done:     return q.done ? "done:yes" : "done:no";
+        case QueryOp::Due:
+            if (q.cmp == "none" || q.cmp == "any") return "due:" + q.cmp;
+            return "due" + q.cmp + q.value;
+        case QueryOp::Text:     return "\"" + q.value + "\"";
+        case QueryOp::Not:      return "NOT " + describeQuery(q.children[0]);
+        default: break;
+    }
+    string out = "(";
+    for (size_t i = 0; i < q.children.size(); ++i) {
+        if (i > 0) out += (q.op == QueryOp::Or) ? " OR " : " AND ";
+        out += describeQuery(q.children[i]);
+    }
+    return out + ")";
+}
+
+// Phrase (already lowercase) starts at a word boundary somewhere in title
+bool matchesWordPrefix(const string& title, const string& phrase) {
+    if (phrase.size() > title.size()) return false;
+    for (size_t start = 0; start + phrase.size() <= title.size(); ++start) {
+        if (start > 0 && isWordChar((unsigned char)title[start - 1])) continue;
+        size_t k = 0;
+        while (k < phrase.size() && tolower((unsigned char)title[start + k]) == (unsigned char)phrase[k]) ++k;
+        if (k == phrase.size()) return true;
+    }
+    return false;
+}
+
+bool evalQuery(const QueryNode& q, const Task& t) {
+    switch (q.op) {
+        case QueryOp::And:
+            for (const auto& c : q.children) if (!evalQuery(c, t)) return false;
+            return true;
+        case QueryOp::Or:
+            for (const auto& c : q.children) if (evalQuery(c, t)) return true;
+            return false;
+        case QueryOp::Not:      return !evalQuery(q.children[0], t);
+        case QueryOp::Priority: return t.priority == q.priority;
+        case QueryOp::Done:     return t.completed == q.done;
+        case QueryOp::Due:
+            if (q.cmp == "none") return t.dueDate.empty();
+            if (t.dueDate.empty()) return false;
+            if (q.cmp == "any") return true;
+            if (q.cmp == "<")  return t.dueDate < q.value;
+            if (q.cmp == "<=") return t.dueDate <= q.value;
+            if (q.cmp == ">")  return t.dueDate > q.value;
+            if (q.cmp == ">=") return t.dueDate >= q.value;
+            return t.dueDate == q.value;
+        case QueryOp::Text:     return matchesWordPrefix(t.title, q.value);
+    }
+    return false;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// QUERY PLANNER
+// ═══════════════════════════════════════════════════════════════════
+
+const size_t NOT_INDEXABLE = numeric_limits<size_t>::max();
+
+// Leading word of a text term, usable as a key into the word index
+string leadingWord(const string& phrase) {
+    size_t n = 0;
+    while (n < phrase.size() && isWordChar((unsigned char)phrase[n])) ++n;
+    return phrase.substr(0, n);
+}
+
+// Range of byDue covered by a due-date comparison
+pair<size_t, size_t> dueRange(const TaskIndex& idx, const vector<Task>& tasks, const QueryNode& q) {
+    auto lessDue = [&](uint32_t i, const string& d) { return tasks[i].dueDate < d; };
+    auto dueLess = [&](const string& d, uint32_t i) { return d < tasks[i].dueDate; };
+    size_t lo = 0, hi = idx.byDue.size();
+    if (q.cmp == "<" || q.cmp == "<=" || q.cmp == "=") {
+        hi = (q.cmp == "<") ? lower_bound(idx.byDue.begin(), idx.byDue.end(), q.value, lessDue) - idx.byDue.begin()
+                            : upper_bound(idx.byDue.begin(), idx.byDue.end(), q.value, dueLess) - idx.byDue.begin();
+    }
+    if (q.cmp == ">" || q.cmp == ">=" || q.cmp == "=") {
+        lo = (q.cmp == ">") ? upper_bound(idx.byDue.begin(), idx.byDue.end(), q.value, dueLess) - idx.byDue.begin()
+                            : lower_bound(idx.byDue.begin(), idx.byDue.end(), q.value, lessDue) - idx.byDue.begin();
+    }
+    return make_pair(lo, max(lo, hi));
+}
+
+// Upper bound on the rows an index can hand back for a single predicate
+size_t estimateRows(const TaskIndex& idx, const vector<Task>& tasks, const QueryNode& q) {
+    switch (q.op) {
+        case QueryOp::Priority: return idx.byPriority[(int)q.priority].size();
+        case QueryOp::Done:     return q.done ? idx.doneCount : tasks.size() - idx.doneCount;
+        case QueryOp::Due: {
+            if (q.cmp == "none") return NOT_INDEXABLE;
+            pair<size_t, size_t> r = dueRange(idx, tasks, q);
+            return r.second - r.first;
+        }
+        case QueryOp::Text: {
+            string key = leadingWord(q.value);
+            if (key.empty()) return NOT_INDEXABLE;
+            size_t total = 0;
+            for (auto it = idx.words.lower_bound(key); it != idx.words.end() && it->first.compare(0, key.size(), key) == 0; ++it) {
+                total += it->second.size();
+            }
+            return total;
+        }
+        default:
+            return NOT_INDEXABLE;
+    }
+}
+
+string describeAccess(const QueryNode& q) {
+    switch (q.op) {
+        case QueryOp::Priority: return "priority bucket [" + priorityToString(q.priority) + "]";
+        case QueryOp::Done:     return string("completion bitmap (") + (q.done ? "set" : "clear") + " bits)";
+        case QueryOp::Due:      return "due-date order (" + describeQuery(q) + ")";
+        case QueryOp::Text:     return "word index (prefix \"" + leadingWord(q.value) + "\")";
+        default:                return "full scan";
+    }
+}
+
+// Ascending task positions the chosen index yields for a predicate
+vector<uint32_t> fetchRows(const TaskIndex& idx, const vector<Task>& tasks, const QueryNode& q) {
+    vector<uint32_t> rows;
+    switch (q.op) {
+        case QueryOp::Priority:
+            rows = idx.byPriority[(int)q.priority];
+            break;
+        case QueryOp::Done:
+            for (size_t w = 0; w < idx.doneBits.size(); ++w) {
+                uint64_t bits = q.done ? idx.doneBits[w] : ~idx.doneBits[w];
+                while (bits) {
+                    uint32_t i = (uint32_t)(w * 64 + __builtin_ctzll(bits));
+                    if (i >= tasks.size()) break;
+                    rows.push_back(i);
+                    bits &= bits - 1;
+                }
+            }
+            break;
+        case QueryOp::Due: {
+            pair<size_t, size_t> r = dueRange(idx, tasks, q);
+            rows.assign(idx.byDue.begin() + r.first, idx.byDue.begin() + r.second);
+            sort(rows.begin(), rows.end());
+            break;
+        }
+        case QueryOp::Text: {
+            string key = leadingWord(q.value);
+            for (auto it = idx.words.lower_bound(key); it != idx.words.end() && it->first.compare(0, key.size(), key) == 0; ++it) {
+                rows.insert(rows.end(), it->second.begin(), it->second.end());
+            }
+            sort(rows.begin(), rows.end());
+            rows.erase(unique(rows.begin(), rows.end()), rows.end());
+            break;
+        }
+        default:
+            break;
+    }
+    return rows;
+}
+
+struct QueryResult {
+    vector<uint32_t> matches;   // ascending task positions
+    string plan;
+    size_t examined = 0;
+};
+
+// Drives the scan from the most selective indexed conjunct, then checks
+// the whole predicate on just those rows.
+QueryResult runQuery(const vector<Task>& tasks, const QueryNode& q) {
+    const TaskIndex& idx = ensureTaskIndex(tasks);
+    QueryResult res;
+
+    const QueryNode* driver = nullptr;
+    size_t best = NOT_INDEXABLE;
+    if (q.op == QueryOp::And) {
+        for (const auto& c : q.children) {
+            size_t est = estimateRows(idx, tasks, c);
+            if (est < best) {
+                best = est;
+                driver = &c;
+            }
+        }
+    } else {
+        best = estimateRows(idx, tasks, q);
+        if (best != NOT_INDEXABLE) driver = &q;
+    }
+
+    if (driver && best < tasks.size()) {
+        vector<uint32_t> rows = fetchRows(idx, tasks, *driver);
+        res.plan = "index scan on " + describeAccess(*driver);
+        res.examined = rows.size();
+        for (uint32_t i : rows) {
+            if (evalQuery(q, tasks[i])) res.matches.push_back(i);
+        }
+    } else {
+        res.plan = "full scan";
+        res.examined = tasks.size();
+        for (uint32_t i = 0; i < (uint32_t)tasks.size(); ++i) {
+            if (evalQuery(q, tasks[i])) res.matches.push_back(i);
+        }
+    }
+    return res;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// RANKED SEARCH
+// ═══════════════════════════════════════════════════════════════════
+
+const double BM25_K1 = 1.2;
+const double BM25_B = 0.75;
+const size_t RANKED_TOP_N = 20;
+
+// BM25 term statistics keyed by task id, so reordering the list never
+// invalidates them. Patched by the note* change hooks as tasks change.
+struct TextIndex {
+    uint64_t version = 0;
+    unordered_map<string, unordered_map<uint32_t, uint32_t>> postings;  // term -> id -> term frequency
+    unordered_map<uint32_t, uint32_t> docLength;                         // id -> words in title
+    uint64_t totalLength = 0;
+};
+
+// Task id -> current position in the list
+struct PositionIndex {
+    uint64_t version = 0;
+    unordered_map<uint32_t, uint32_t> of;
+};
+
+TextIndex textIndex;
+PositionIndex positionIndex;
+
+void textIndexAdd(const Task& t) {
+    vector<string> words = titleWords(t.title);
+    for (const auto& w : words) {
+        ++textIndex.postings[w][t.id];
+    }
+    textIndex.docLength[t.id] = (uint32_t)words.size();
+    textIndex.totalLength += words.size();
+}
+
+void textIndexRemove(const Task& t) {
+    for (const auto& w : titleWords(t.title)) {
+        auto it = textIndex.postings.find(w);
+        if (it == textIndex.postings.end()) continue;
+        it->second.erase(t.id);
+        if (it->second.empty()) textIndex.postings.erase(it);
+    }
+    auto len = textIndex.docLength.find(t.id);
+    if (len != textIndex.docLength.end()) {
+        textIndex.totalLength -= len->second;
+        textIndex.docLength.erase(len);
+    }
+}
+
+const TextIndex& ensureTextIndex(const vector<Task>& tasks) {
+    if (textIndex.version == storeVersion) return textIndex;
+    textIndex = TextIndex();
+    for (const auto& t : tasks) textIndexAdd(t);
+    textIndex.version = storeVersion;
+    return textIndex;
+}
+
+const PositionIndex& ensurePositionIndex(const vector<Task>& tasks) {
+    if (positionIndex.version == storeVersion) return positionIndex;
+    positionIndex.of.clear();
+    for (uint32_t i = 0; i < (uint32_t)tasks.size(); ++i) positionIndex.of[tasks[i].id] = i;
+    positionIndex.version = storeVersion;
+    return positionIndex;
+}
+
+struct RankedHit {
+    uint32_t index;   // position in the task list
+    double score;
+};
+
+// Term-at-a-time BM25 with a MaxScore cut-off: terms are visited from the
+// highest possible contribution down, and once the remaining terms cannot
+// lift an unseen title past the current N-th best score they only update
+// titles that are already candidates.
+vector<RankedHit> rankedSearch(const vector<Task>& tasks, const string& query, size_t topN) {
+    const TextIndex& idx = ensureTextIndex(tasks);
+    const PositionIndex& pos = ensurePositionIndex(tasks);
+    vector<RankedHit> hits;
+    if (idx.docLength.empty()) return hits;
+
+    struct TermInfo {
+        const unordered_map<uint32_t, uint32_t>* postings;
+        double idf;
+        double bound;   // largest score this term can add to any title
+    };
+
+    vector<string> words = titleWords(query);
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+
+    const double docs = (double)idx.docLength.size();
+    const double avgLength = (double)idx.totalLength / docs;
+    vector<TermInfo> terms;
+    for (const auto& w : words) {
+        auto it = idx.postings.find(w);
+        if (it == idx.postings.end()) continue;
+        double df = (double)it->second.size();
+        double idf = log(1.0 + (docs - df + 0.5) / (df + 0.5));
+        terms.push_back({&it->second, idf, idf * (BM25_K1 + 1.0)});
+    }
+    sort(terms.begin(), terms.end(), [](const TermInfo& a, const TermInfo& b) { return a.bound > b.bound; });
+
+    vector<double> remaining(terms.size() + 1, 0.0);
+    for (size_t i = terms.size(); i-- > 0;) remaining[i] = remaining[i + 1] + terms[i].bound;
+
+    unordered_map<uint32_t, double> scores;
+    bool admitNew = true;
+    for (size_t t = 0; t < terms.size(); ++t) {
+        for (const auto& p : *terms[t].postings) {
+            auto acc = scores.find(p.first);
+            if (acc == scores.end()) {
+                if (!admitNew) continue;
+                acc = scores.emplace(p.first, 0.0).first;
+            }
+            double tf = p.second;
+            double norm = BM25_K1 * (1.0 - BM25_B + BM25_B * idx.docLength.at(p.first) / avgLength);
+            acc->second += terms[t].idf * tf * (BM25_K1 + 1.0) / (tf + norm);
+        }
+
+        if (admitNew && scores.size() >= topN && t + 1 < terms.size()) {
+            vector<double> current;
+            current.reserve(scores.size());
+            for (const auto& s : scores) current.push_back(s.second);
+            nth_element(current.begin(), current.begin() + (topN - 1), current.end(), greater<double>());
+            if (remaining[t + 1] < current[topN - 1]) admitNew = false;
+        }
+    }
+
+    hits.reserve(scores.size());
+    for (const auto& s : scores) {
+        hits.push_back({pos.of.at(s.first), s.second});
+    }
+    auto better = [](const RankedHit& a, const RankedHit& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.index < b.index;
+    };
+    size_t keep = min(topN, hits.size());
+    partial_sort(hits.begin(), hits.begin() + keep, hits.end(), better);
+    hits.resize(keep);
+    return hits;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// SORTING
+// ═══════════════════════════════════════════════════════════════════
+//
+// A sort spec such as "priority desc, due asc, title asc" is compiled
+// into one packed 64-bit key per task (first field in the high bits) and
+// ordered with a stable LSD radix sort, so ties keep their previous order.
+
+enum class SortKey { Priority, Completed, Due, Title };
+
+struct SortField {
+    SortKey key;
+    bool descending;
+};
+
+typedef vector<SortField> SortSpec;
+
+const int RADIX_BITS = 11;
+const int DUE_BITS = 23;   // ordinals stay below 2^22; the top value marks "no date"
+
+const char* sortKeyName(SortKey k) {
+    switch (k) {
+        case SortKey::Priority:  return "priority";
+        case SortKey::Completed: return "completed";
+        case SortKey::Due:       return "due";
+        case SortKey::Title:     return "title";
+    }
+    return "";
+}
+
+bool parseSortSpec(const string& text, SortSpec& spec, string& error) {
+    spec.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == string::npos) comma = text.size();
+        istringstream part(toLower(text.substr(start, comma - start)));
+        start = comma + 1;
+
+        string name, dir, extra;
+        part >> name >> dir >> extra;
+        if (name.empty()) continue;
+
+        SortField f;
+        if (name == "priority" || name == "p") f.key = SortKey::Priority;
+        else if (name == "completed" || name == "completion" || name == "done") f.key = SortKey::Completed;
+        else if (name == "due" || name == "duedate") f.key = SortKey::Due;
+        else if (name == "title") f.key = SortKey::Title;
+        else {
+            error = "Unknown sort key '" + name + "'";
+            return false;
+        }
+
+        if (dir.empty() || dir == "asc") f.descending = false;
+        else if (dir == "desc") f.descending = true;
+        else {
+            error = "Expected asc or desc after '" + name + "'";
+            return false;
+        }
+        if (!extra.empty()) {
+            error = "Separate sort keys with commas";
+            return false;
+        }
+
+        for (const auto& g : spec) {
+            if (g.key == f.key) {
+                error = string("Sort key '") + sortKeyName(f.key) + "' given twice";
+                return false;
+            }
+        }
+        spec.push_back(f);
+    }
+    if (spec.empty()) {
+        error = "Sort specification is empty";
+        return false;
+    }
+    return true;
+}
+
+string describeSortSpec(const SortSpec& spec) {
+    string out;
+    for (size_t i = 0; i < spec.size(); ++i) {
+        if (i > 0) out += ", ";
+        out += sortKeyName(spec[i].key);
+        out += spec[i].descending ? " desc" : " asc";
+    }
+    return out;
+}
+
+// Orders valid YYYY-MM-DD dates; 0 means no (or unparseable) date
+uint32_t dueOrdinal(const string& due) {
+    if (!isDate(due)) return 0;
+    auto digits = [&](size_t from, size_t count) {
+        uint32_t v = 0;
+        for (size_t i = from; i < from + count; ++i) v = v * 10 + (uint32_t)(due[i] - '0');
+        return v;
+    };
+    return digits(0, 4) * 372 + digits(5, 2) * 31 + digits(8, 2) + 1;
+}
+
+int bitsFor(uint64_t maxValue) {
+    int bits = 0;
+    while (bits < 64 && (maxValue >> bits) != 0) ++bits;
+    return bits;
+}
+
+// MSD radix sort of positions by title bytes; bucket 0 holds titles that
+// end at this depth. Small buckets finish with insertion sort.
+void msdSortTitles(const vector<Task>& tasks, uint32_t* idx, size_t n, size_t depth, vector<uint32_t>& scratch) {
+    if (n < 2) return;
+    if (n < 32) {
+        for (size_t i = 1; i < n; ++i) {
+            uint32_t v = idx[i];
+            size_t j = i;
+            while (j > 0 && tasks[idx[j - 1]].title.compare(depth, string::npos, tasks[v].title, depth, string::npos) > 0) {
+                idx[j] = idx[j - 1];
+                --j;
+            }
+            idx[j] = v;
+        }
+        return;
+    }
+
+    auto byteAt = [&](uint32_t i) {
+        const string& s = tasks[i].title;
+        return depth < s.size() ? (size_t)(unsigned char)s[depth] + 1 : 0;
+    };
+
+    size_t count[258] = {0};
+    for (size_t i = 0; i < n; ++i) ++count[byteAt(idx[i]) + 1];
+    for (int b = 0; b < 257; ++b) count[b + 1] += count[b];
+
+    size_t offsets[258];
+    copy(begin(count), end(count), begin(offsets));
+    for (size_t i = 0; i < n; ++i) scratch[offsets[byteAt(idx[i])]++] = idx[i];
+    copy(scratch.begin(), scratch.begin() + n, idx);
+
+    for (int b = 1; b < 257; ++b) {
+        msdSortTitles(tasks, idx + count[b], count[b + 1] - count[b], depth + 1, scratch);
+    }
+}
+
+// Dense title ranks: equal titles share a rank
+vector<uint32_t> titleRanks(const vector<Task>& tasks, uint32_t& maxRank) {
+    vector<uint32_t> order(tasks.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); ++i) order[i] = i;
+    vector<uint32_t> scratch(order.size());
+    msdSortTitles(tasks, order.data(), order.size(), 0, scratch);
+
+    vector<uint32_t> rank(tasks.size());
+    maxRank = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && tasks[order[i]].title != tasks[order[i - 1]].title) ++maxRank;
+        rank[order[i]] = maxRank;
+    }
+    return rank;
+}
+
+// Packs every field of the spec into one key per task; returns the bit width used
+int packSortKeys(const vector<Task>& tasks, const SortSpec& spec, vector<uint64_t>& keys) {
+    keys.assign(tasks.size(), 0);
+    int totalBits = 0;
+
+    for (const auto& f : spec) {
+        vector<uint32_t> ranks;
+        uint64_t maxValue = 0;
+        int width = 0;
+        switch (f.key) {
+            case SortKey::Priority:  width = 2; maxValue = 2; break;
+            case SortKey::Completed: width = 1; maxValue = 1; break;
+            case SortKey::Due:       width = DUE_BITS; maxValue = (1ULL << DUE_BITS) - 1; break;
+            case SortKey::Title: {
+                uint32_t maxRank = 0;
+                ranks = titleRanks(tasks, maxRank);
+                maxValue = maxRank;
+                width = max(1, bitsFor(maxRank));
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            const Task& t = tasks[i];
+            uint64_t v = 0;
+            switch (f.key) {
+                case SortKey::Priority:  v = (uint64_t)t.priority; break;
+                case SortKey::Completed: v = t.completed ? 1 : 0; break;
+                case SortKey::Due: {
+                    // Tasks without a date go last in either direction
+                    uint32_t d = dueOrdinal(t.dueDate);
+                    v = d == 0 ? maxValue : (f.descending ? (1ULL << (DUE_BITS - 1)) - d : d);
+                    break;
+                }
+                case SortKey::Title:     v = ranks[i]; break;
+            }
+            if (f.descending && f.key != SortKey::Due) v = maxValue - v;
+            keys[i] = (keys[i] << width) | v;
+        }
+        totalBits += width;
+    }
+    return totalBits;
+}
+
+// Sort key paired with the task position it belongs to
+struct KeyIndex {
+    uint64_t key;
+    uint32_t index;
+};
+
+// Lists smaller than this sort faster on one thread than the spawn costs
+const size_t PARALLEL_SORT_MIN = 1 << 16;
+
+// Stable LSD radix sort by key; passes whose digit is the same for every
+// key are skipped. The result always ends up back in data.
+void radixSortPairs(KeyIndex* data, KeyIndex* scratch, size_t n, int bits) {
+    const size_t buckets = 1u << RADIX_BITS;
+    vector<size_t> count(buckets);
+    KeyIndex* src = data;
+    KeyIndex* dst = scratch;
+
+    for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+        fill(count.begin(), count.end(), 0);
+        for (size_t i = 0; i < n; ++i) ++count[(src[i].key >> shift) & (buckets - 1)];
+        if (n == 0 || count[(src[0].key >> shift) & (buckets - 1)] == n) continue;
+
+        size_t sum = 0;
+        for (auto& c : count) {
+            size_t k = c;
+            c = sum;
+            sum += k;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            dst[count[(src[i].key >> shift) & (buckets - 1)]++] = src[i];
+        }
+        swap(src, dst);
+    }
+    if (src != data) copy(src, src + n, data);
+}
+
+// Radix-sorts one slice per core, then merges neighbouring slices in
+// parallel rounds. Slices follow list order and std::merge prefers the
+// left slice on ties, so the result is identical to the serial sort.
+void parallelSortPairs(vector<KeyIndex>& pairs, int bits, unsigned workers) {
+    const size_t n = pairs.size();
+    vector<KeyIndex> scratch(n);
+    vector<size_t> bounds;
+    for (unsigned c = 0; c <= workers; ++c) bounds.push_back(n * c / workers);
+
+    vector<thread> pool;
+    for (unsigned c = 0; c < workers; ++c) {
+        size_t lo = bounds[c], hi = bounds[c + 1];
+        pool.emplace_back([&pairs, &scratch, lo, hi, bits] {
+            radixSortPairs(pairs.data() + lo, scratch.data() + lo, hi - lo, bits);
+        });
+    }
+    for (auto& t : pool) t.join();
+
+    auto byKey = [](const KeyIndex& a, const KeyIndex& b) { return a.key < b.key; };
+    KeyIndex* src = pairs.data();
+    KeyIndex* dst = scratch.data();
+    while (bounds.size() > 2) {
+        vector<size_t> next;
+        pool.clear();
+        for (size_t c = 0; c + 1 < bounds.size(); c += 2) {
+            size_t lo = bounds[c], mid = bounds[c + 1];
+            size_t hi = (c + 2 < bounds.size()) ? bounds[c + 2] : mid;
+            next.push_back(lo);
+            pool.emplace_back([=] { merge(src + lo, src + mid, src + mid, src + hi, dst + lo, byKey); });
+        }
+        next.push_back(bounds.back());
+        for (auto& t : pool) t.join();
+        swap(src, dst);
+        bounds.swap(next);
+    }
+    if (src != pairs.data()) pairs.swap(scratch);
+}
+
+// Positions in sorted order; large lists are sorted across all cores
+vector<uint32_t> radixOrder(const vector<uint64_t>& keys, int bits) {
+    const size_t n = keys.size();
+    vector<KeyIndex> pairs(n);
+    for (uint32_t i = 0; i < (uint32_t)n; ++i) pairs[i] = {keys[i], i};
+
+    unsigned workers = thread::hardware_concurrency();
+    if (n >= PARALLEL_SORT_MIN && workers > 1) {
+        parallelSortPairs(pairs, bits, workers);
+    } else {
+        vector<KeyIndex> scratch(n);
+        radixSortPairs(pairs.data(), scratch.data(), n, bits);
+    }
+
+    vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = pairs[i].index;
+    return order;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// VIEWS
+// ═══════════════════════════════════════════════════════════════════
+//
+// Display order is kept apart from the storage order, so sorting never
+// moves Task objects, needs no undo snapshot and persists as nothing but
+// its spec in views.json. Several named views can coexist; one is active,
+// and every view that has been built stays sorted as tasks change.
+
+// Snapshot of the fields a view sorts by. seq is the task's place in the
+// order shown before the view was last built (or, for later additions,
+// when it entered the view) and breaks ties, so deleting other tasks never
+// has to renumber anything.
+struct ViewKey {
+    uint8_t priority;
+    uint8_t completed;
+    uint32_t due;       // dueOrdinal, 0 = no date
+    string title;       // only filled when the spec sorts by title
+    uint32_t seq;
+};
+
+ViewKey makeViewKey(const SortSpec& spec, const Task& t, uint32_t seq) {
+    ViewKey k;
+    k.priority = (uint8_t)t.priority;
+    k.completed = t.completed ? 1 : 0;
+    k.due = dueOrdinal(t.dueDate);
+    k.seq = seq;
+    for (const auto& f : spec) {
+        if (f.key == SortKey::Title) k.title = t.title;
+    }
+    return k;
+}
+
+// Same order as packSortKeys + radixOrder, expressed as a comparison
+bool viewKeyLess(const SortSpec& spec, const ViewKey& a, const ViewKey& b) {
+    for (const auto& f : spec) {
+        int c = 0;
+        switch (f.key) {
+            case SortKey::Priority:  c = (int)a.priority - (int)b.priority; break;
+            case SortKey::Completed: c = (int)a.completed - (int)b.completed; break;
+            case SortKey::Due:
+                if ((a.due == 0) != (b.due == 0)) return b.due == 0;  // undated last either way
+                c = (a.due < b.due) ? -1 : (a.due > b.due ? 1 : 0);
+                break;
+            case SortKey::Title:     c = a.title.compare(b.title); break;
+        }
+        if (c != 0) return f.descending ? c > 0 : c < 0;
+    }
+    return a.seq < b.seq;
+}
+
+// Order-statistic treap of task ids. Nodes live in a pool and link by
+// index; every subtree knows its size, so insert, erase, select(row) and
+// rank(id) are all O(log n).
+class ViewTree {
+public:
+    SortSpec spec;
+
+    void clear() {
+        pool.clear();
+        freeSlots.clear();
+        nodeOf.clear();
+        root = -1;
+    }
+
+    size_t size() const { return root < 0 ? 0 : pool[root].size; }
+
+    // Builds from ids already in view order in O(n)
+    void build(const vector<pair<uint32_t, ViewKey>>& sorted) {
+        clear();
+        pool.reserve(sorted.size());
+        vector<int> spine;  // right spine of the Cartesian tree built so far
+        for (const auto& e : sorted) {
+            int n = allocate(e.first, e.second);
+            int last = -1;
+            while (!spine.empty() && pool[spine.back()].weight < pool[n].weight) {
+                last = spine.back();
+                spine.pop_back();
+            }
+            pool[n].left = last;
+            if (!spine.empty()) pool[spine.back()].right = n;
+            spine.push_back(n);
+        }
+        root = spine.empty() ? -1 : spine.front();
+        if (root >= 0) fixSizes(root);
+    }
+
+    void insert(uint32_t id, const ViewKey& key) {
+        int n = allocate(id, key);
+        int l, r;
+        split(root, key, l, r);
+        root = merge(merge(l, n), r);
+    }
+
+    void erase(uint32_t id) {
+        auto it = nodeOf.find(id);
+        if (it == nodeOf.end()) return;
+        int l, mid, r;
+        split(root, pool[it->second].key, l, r);
+        splitFirst(r, mid, r);
+        root = merge(l, r);
+        freeSlots.push_back(mid);
+        nodeOf.erase(it);
+    }
+
+    const ViewKey* keyOf(uint32_t id) const {
+        auto it = nodeOf.find(id);
+        return it == nodeOf.end() ? nullptr : &pool[it->second].key;
+    }
+
+    // Task id shown at a 0-based row
+    uint32_t select(size_t row) const {
+        int t = root;
+        while (true) {
+            size_t leftSize = sizeOf(pool[t].left);
+            if (row < leftSize) {
+                t = pool[t].left;
+            } else if (row == leftSize) {
+                return pool[t].id;
+            } else {
+                row -= leftSize + 1;
+                t = pool[t].right;
+            }
+        }
+    }
+
+    // 0-based row of a task id
+    size_t rank(uint32_t id) const {
+        const ViewKey& key = pool[nodeOf.at(id)].key;
+        size_t row = 0;
+        int t = root;
+        while (t >= 0) {
+            if (pool[t].id == id) return row + sizeOf(pool[t].left);
+            if (viewKeyLess(spec, key, pool[t].key)) {
+                t = pool[t].left;
+            } else {
+                row += sizeOf(pool[t].left) + 1;
+                t = pool[t].right;
+            }
+        }
+        return row;
+    }
+
+    // Calls fn(id) for rows [from, from + count) in order, never touching other rows
+    template <typename F>
+    void visit(size_t from, size_t count, F fn) const {
+        visitNode(root, from, count, fn);
+    }
+
+private:
+    struct Node {
+        ViewKey key;
+        uint32_t id;
+        uint32_t weight;   // random heap priority
+        uint32_t size;
+        int left, right;
+    };
+
+    vector<Node> pool;
+    vector<int> freeSlots;
+    unordered_map<uint32_t, int> nodeOf;   // task id -> node
+    int root = -1;
+    uint32_t seed = 0x9E3779B9u;
+
+    uint32_t nextWeight() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    int allocate(uint32_t id, const ViewKey& key) {
+        Node n = {key, id, nextWeight(), 1, -1, -1};
+        int slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            pool[slot] = move(n);
+        } else {
+            slot = (int)pool.size();
+            pool.push_back(move(n));
+        }
+        nodeOf[id] = slot;
+        return slot;
+    }
+
+    size_t sizeOf(int t) const { return t < 0 ? 0 : pool[t].size; }
+
+    void pull(int t) { pool[t].size = (uint32_t)(1 + sizeOf(pool[t].left) + sizeOf(pool[t].right)); }
+
+    uint32_t fixSizes(int t) {
+        if (t < 0) return 0;
+        pool[t].size = 1 + fixSizes(pool[t].left) + fixSizes(pool[t].right);
+        return pool[t].size;
+    }
+
+    // l gets keys before key, r the rest
+    void split(int t, const ViewKey& key, int& l, int& r) {
+        if (t < 0) {
+            l = r = -1;
+        } else if (viewKeyLess(spec, pool[t].key, key)) {
+            split(pool[t].right, key, pool[t].right, r);
+            l = t;
+            pull(t);
+        } else {
+            split(pool[t].left, key, l, pool[t].left);
+            r = t;
+            pull(t);
+        }
+    }
+
+    void splitFirst(int t, int& first, int& rest) {
+        if (pool[t].left < 0) {
+            first = t;
+            rest = pool[t].right;
+            pool[t].right = -1;
+            pull(t);
+            return;
+        }
+        splitFirst(pool[t].left, first, pool[t].left);
+        rest = t;
+        pull(t);
+    }
+
+    int merge(int a, int b) {
+        if (a < 0) return b;
+        if (b < 0) return a;
+        if (pool[a].weight > pool[b].weight) {
+            pool[a].right = merge(pool[a].right, b);
+            pull(a);
+            return a;
+        }
+        pool[b].left = merge(a, pool[b].left);
+        pull(b);
+        return b;
+    }
+
+    template <typename F>
+    void visitNode(int t, size_t& from, size_t& count, F& fn) const {
+        if (t < 0 || count == 0) return;
+        size_t leftSize = sizeOf(pool[t].left);
+        if (from < leftSize) {
+            visitNode(pool[t].left, from, count, fn);
+        } else {
+            from -= leftSize;
+        }
+        if (count == 0) return;
+        if (from == 0) {
+            fn(pool[t].id);
+            --count;
+        } else {
+            --from;
+        }
+        visitNode(pool[t].right, from, count, fn);
+    }
+};
+
+struct TaskView {
+    SortSpec spec;              // empty = storage order, which needs no tree
+    uint64_t version = 0;       // storeVersion the tree reflects
+    ViewTree tree;
+    uint32_t nextSeq = 0;
+    vector<uint32_t> tieOrder;  // ids as shown before a spec change, until the next build
+};
+
+const string DEFAULT_VIEW = "main";
+
+map<string, TaskView> views = {{DEFAULT_VIEW, TaskView()}};
+string activeViewName = DEFAULT_VIEW;
+
+// Ids in the order the view lists them, or empty for storage order
+vector<uint32_t> shownIds(const TaskView& v) {
+    vector<uint32_t> ids;
+    if (v.spec.empty()) return ids;
+    ids.reserve(v.tree.size());
+    v.tree.visit(0, v.tree.size(), [&](uint32_t id) { ids.push_back(id); });
+    return ids;
+}
+
+// Ties are broken by the order the tasks were shown in before: the one
+// saved by setViewSpec, else the view's previous tree. Tasks missing from
+// it follow in storage order.
+void rebuildView(TaskView& v, const vector<Task>& tasks) {
+    if (v.tieOrder.empty()) v.tieOrder = shownIds(v);
+    v.tree.clear();
+    v.tree.spec = v.spec;
+    if (!v.spec.empty()) {
+        vector<uint32_t> before;
+        if (!v.tieOrder.empty()) {
+            const PositionIndex& pos = ensurePositionIndex(tasks);
+            vector<char> placed(tasks.size(), 0);
+            before.reserve(tasks.size());
+            for (uint32_t id : v.tieOrder) {
+                auto it = pos.of.find(id);
+                if (it == pos.of.end() || placed[it->second]) continue;
+                placed[it->second] = 1;
+                before.push_back(it->second);
+            }
+            for (uint32_t i = 0; i < (uint32_t)tasks.size(); ++i) {
+                if (!placed[i]) before.push_back(i);
+            }
+        }
+
+        vector<uint64_t> keys;
+        int bits = packSortKeys(tasks, v.spec, keys);
+        if (!before.empty()) {
+            vector<uint64_t> byBefore(keys.size());
+            for (size_t j = 0; j < before.size(); ++j) byBefore[j] = keys[before[j]];
+            keys.swap(byBefore);
+        }
+        vector<pair<uint32_t, ViewKey>> sorted;
+        sorted.reserve(tasks.size());
+        for (uint32_t seq : radixOrder(keys, bits)) {
+            uint32_t i = before.empty() ? seq : before[seq];
+            sorted.push_back(make_pair(tasks[i].id, makeViewKey(v.spec, tasks[i], seq)));
+        }
+        v.tree.build(sorted);
+    }
+    v.tieOrder.clear();
+    v.tieOrder.shrink_to_fit();
+    v.nextSeq = (uint32_t)tasks.size();
+    v.version = storeVersion;
+}
+
+// Full rebuilds happen only after undo, redo, load or a spec change;
+// ordinary edits are patched into the tree by the change hooks.
+const TaskView& activeView(const vector<Task>& tasks) {
+    TaskView& v = views[activeViewName];
+    if (v.version != storeVersion) rebuildView(v, tasks);
+    return v;
+}
+
+void viewTaskAdded(TaskView& v, const Task& t) {
+    if (!v.spec.empty()) v.tree.insert(t.id, makeViewKey(v.spec, t, v.nextSeq));
+    ++v.nextSeq;
+}
+
+void viewTaskChanged(TaskView& v, const Task& before, const Task& after) {
+    if (v.spec.empty()) return;
+    const ViewKey* old = v.tree.keyOf(before.id);
+    if (!old) return;
+    ViewKey key = makeViewKey(v.spec, after, old->seq);
+    if (!viewKeyLess(v.spec, key, *old) && !viewKeyLess(v.spec, *old, key)) return;
+    v.tree.erase(before.id);
+    v.tree.insert(after.id, key);
+}
+
+void viewTaskRemoved(TaskView& v, const Task& removed) {
+    if (!v.spec.empty()) v.tree.erase(removed.id);
+}
+
+// Identifies what the active view shows, for caching rendered output
+string activeViewKey() {
+    return activeViewName + '|' + describeSortSpec(views[activeViewName].spec);
+}
+
+// 1-based number the user sees for a storage position
+size_t displayNumber(const vector<Task>& tasks, size_t pos) {
+    const TaskView& v = activeView(tasks);
+    if (v.spec.empty()) return pos + 1;
+    return v.tree.rank(tasks[pos].id) + 1;
+}
+
+// Storage position for a number the user typed, or -1
+int positionForNumber(const vector<Task>& tasks, int number) {
+    if (number < 1 || number > (int)tasks.size()) return -1;
+    const TaskView& v = activeView(tasks);
+    if (v.spec.empty()) return number - 1;
+    return (int)ensurePositionIndex(tasks).of.at(v.tree.select(number - 1));
+}
+
+// Calls fn(position) for display rows [from, from + count) of the active view
+template <typename F>
+void forEachRow(const vector<Task>& tasks, size_t from, size_t count, F fn) {
+    const TaskView& v = activeView(tasks);
+    count = from < tasks.size() ? min(count, tasks.size() - from) : 0;
+    if (v.spec.empty()) {
+        for (size_t i = from; i < from + count; ++i) fn((uint32_t)i);
+        return;
+    }
+    const PositionIndex& pos = ensurePositionIndex(tasks);
+    v.tree.visit(from, count, [&](uint32_t id) { fn(pos.of.at(id)); });
+}
+
+// True if the task at storage position a is listed before the one at b
+bool shownBefore(const vector<Task>& tasks, uint32_t a, uint32_t b) {
+    const TaskView& v = activeView(tasks);
+    if (v.spec.empty()) return a < b;
+    return viewKeyLess(v.spec, *v.tree.keyOf(tasks[a].id), *v.tree.keyOf(tasks[b].id));
+}
+
+// Ties in the new order keep the order the active view showed until now
+void setViewSpec(const vector<Task>& tasks, const string& name, const SortSpec& spec) {
+    TaskView& v = views[name];
+    v.tieOrder = shownIds(activeView(tasks));
+    v.tree.clear();   // empty tieOrder then means storage order
+    v.spec = spec;
+    v.version = 0;
+    activeViewName = name;
+}
+
+void saveViews() {
+    json j;
+    j["active"] = activeViewName;
+    j["views"] = json::array();
+    for (const auto& v : views) {
+        j["views"].push_back({
+            {"name", v.first},
+            {"sort", describeSortSpec(v.second.spec)}
+        });
+    }
+
+    ofstream file("views.json");
+    if (file.is_open()) {
+        file << j.dump(4);
+    }
+}
+
+void loadViews() {
+    ifstream file("views.json");
+    if (!file.is_open()) return;
+
+    json j;
+
+    try {
+        file >> j;
+    } catch (...) {
+        cout << "  " << YELLOW << "[!]" << RESET << " Invalid views file. Using storage order.\n";
+        return;
+    }
+
+    if (j.contains("views") && j["views"].is_array()) {
+        for (const auto& item : j["views"]) {
+            string name = item.value("name", "");
+            string sort = item.value("sort", "");
+            SortSpec spec;
+            string error;
+            if (name.empty() || (!sort.empty() && !parseSortSpec(sort, spec, error))) continue;
+            views[name].spec = spec;
+        }
+    }
+
+    string active = j.value("active", DEFAULT_VIEW);
+    if (views.count(active)) activeViewName = active;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// RESULT CACHE
+// ═══════════════════════════════════════════════════════════════════
+
+// Least-recently-used map from a query string to its result. Each entry
+// remembers the store version it was computed at and is treated as a
+// miss once the store has moved on.
+template <typename V>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {}
+
+    const V* get(const string& key, uint64_t version) {
+        auto it = lookup.find(key);
+        if (it == lookup.end() || it->second->version != version) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->value;
+    }
+
+    const V& put(const string& key, uint64_t version, V value) {
+        auto it = lookup.find(key);
+        if (it != lookup.end()) {
+            entries.erase(it->second);
+            lookup.erase(it);
+        } else if (entries.size() >= capacity) {
+            lookup.erase(entries.back().key);
+            entries.pop_back();
+        }
+        entries.push_front({key, version, move(value)});
+        lookup[key] = entries.begin();
+        return entries.front().value;
+    }
+
+private:
+    struct Entry {
+        string key;
+        uint64_t version;
+        V value;
+    };
+
+    size_t capacity;
+    list<Entry> entries;  // most recently used first
+    unordered_map<string, typename list<Entry>::iterator> lookup;
+};
+
+LruCache<QueryResult> searchCache(32);
+LruCache<string> renderCache(4);
+
+QueryResult computeSearch(const vector<Task>& tasks, int mode, const string& query, const QueryNode& parsed) {
+    if (mode == 3) {
+        // The planner works in storage order; present hits in view order
+        QueryResult res = runQuery(tasks, parsed);
+        sort(res.matches.begin(), res.matches.end(), [&](uint32_t a, uint32_t b) {
+            return shownBefore(tasks, a, b);
+        });
+        return res;
+    }
+
+    QueryResult res;
+    res.examined = tasks.size();
+    if (mode == 5) {
+        res.plan = "BM25 ranking";
+        for (const auto& h : rankedSearch(tasks, query, RANKED_TOP_N)) {
+            res.matches.push_back(h.index);
+        }
+    } else if (mode == 2) {
+        res.plan = "fuzzy ranking";
+        for (const auto& h : fuzzySearch(tasks, query, FUZZY_TOP_K)) {
+            res.matches.push_back((uint32_t)h.index);
+        }
+    } else {
+        // Same case rule as live search, so both modes find the same titles
+        res.plan = "full scan";
+        string needle = toLower(query);
+        forEachRow(tasks, 0, tasks.size(), [&](uint32_t i) {
+            if (containsIgnoreCase(tasks[i].title, needle)) res.matches.push_back(i);
+        });
+    }
+    return res;
+}
+
+// Repeating a search before the next change is a single cache lookup
+const QueryResult& cachedSearch(const vector<Task>& tasks, int mode, const string& query,
+                                const QueryNode& parsed, bool& hit) {
+    // Parsed queries are keyed by their normalized form so spacing does not matter
+    string key = to_string(mode) + ':' + activeViewKey() + ':' + (mode == 3 ? describeQuery(parsed) : query);
+    const QueryResult* cached = searchCache.get(key, storeVersion);
+    hit = (cached != nullptr);
+    if (cached) return *cached;
+    return searchCache.put(key, storeVersion, computeSearch(tasks, mode, query, parsed));
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// LIVE SEARCH
+// ═══════════════════════════════════════════════════════════════════
+
+const int LIVE_SEARCH_ROWS = 15;
+const int LIVE_HEADER_ROWS = 4;
+
+// Narrows the previous hits to titles that still match. Only valid when
+// the query grew, since anything containing the longer query also
+// contained the shorter one.
+void refineHits(const vector<Task>& tasks, const string& needle, vector<uint32_t>& hits) {
+    size_t kept = 0;
+    for (uint32_t i : hits) {
+        if (containsIgnoreCase(tasks[i].title, needle)) hits[kept++] = i;
+    }
+    hits.resize(kept);
+}
+
+void scanHits(const vector<Task>& tasks, const string& needle, vector<uint32_t>& hits) {
+    hits.clear();
+    forEachRow(tasks, 0, tasks.size(), [&](uint32_t i) {
+        if (containsIgnoreCase(tasks[i].title, needle)) hits.push_back(i);
+    });
+}
+
+void liveSearch(const vector<Task>& tasks) {
+    if (!outputIsTerminal() || !inputIsTerminal()) {
+        cout << "  [i] Live search needs an interactive terminal; use mode 1 or 2 instead.\n";
+        return;
+    }
+
+    RawMode raw;
+    Screen screen(LIVE_HEADER_ROWS + LIVE_SEARCH_ROWS + 1, terminalCols());
+    vector<uint32_t> hits;
+    string query;
+    string needle;
+
+    scanHits(tasks, needle, hits);
+
+    while (true) {
+        screen.clear();
+        screen.draw(1, 0, "  ========================== LIVE SEARCH ==========================");
+        screen.draw(3, 0, "  " + to_string(hits.size()) + " of " + to_string(tasks.size()) + " tasks match");
+        for (int r = 0; r < LIVE_SEARCH_ROWS && r < (int)hits.size(); ++r) {
+            screen.draw(LIVE_HEADER_ROWS + r, 0, formatTaskRow(tasks[hits[r]], displayNumber(tasks, hits[r])));
+        }
+        if (hits.size() > (size_t)LIVE_SEARCH_ROWS) {
+            screen.draw(LIVE_HEADER_ROWS + LIVE_SEARCH_ROWS, 0, "  ... " + to_string(hits.size() - LIVE_SEARCH_ROWS) + " more");
+        }
+
+        // Park the cursor at the end of the query line
+        int end = screen.draw(2, 0, "  Search (Enter/Esc to finish): " + query);
+        screen.placeCursor(2, min(end, screen.cols() - 1));
+        screen.flush();
+
+        int key = readKey();
+        if (key == '\r' || key == '\n' || key == 27 || key == EOF) break;
+        if (key == KEY_IGNORED) continue;
+
+        if (key == 8 || key == 127) {
+            if (query.empty()) continue;
+            // One character: any UTF-8 continuation bytes, then the byte that leads them
+            size_t cut = query.size() - 1;
+            while (cut > 0 && ((unsigned char)query[cut] & 0xC0) == 0x80) --cut;
+            query.resize(cut);
+            needle.resize(cut);
+            scanHits(tasks, needle, hits);
+        } else if (key >= 32 && key < 256) {
+            query += (char)key;
+            needle += (char)tolower(key);
+            refineHits(tasks, needle, hits);
+        }
+    }
+
+    cout << "\033[" << LIVE_HEADER_ROWS + LIVE_SEARCH_ROWS + 2 << ";1H\n";
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// URGENCY
+// ═══════════════════════════════════════════════════════════════════
+//
+// "Most urgent" ranks open tasks by
+//   priority (Low 10, Medium 20, High 30)
+//   + overdue: 14 plus 1 per day late, capped at 19 so a late Low task
+//     never outranks an equally old High one on lateness alone,
+//     or due soon: 2 per day inside a week (14 when due today)
+//   + age: 0.25 per day since creation, capped at 60 days
+// Scores depend on today's date, so they are recomputed per request and
+// the best N picked with nth_element in O(n) rather than a full sort.
+
+const size_t URGENT_DEFAULT_COUNT = 20;
+const double OVERDUE_MAX_POINTS = 19.0;
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+long daysFromCivil(long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+}
+
+bool dateToDays(const string& date, long& days) {
+    if (!isDate(date)) return false;
+    long y = stol(date.substr(0, 4));
+    unsigned m = (unsigned)stoul(date.substr(5, 2));
+    unsigned d = (unsigned)stoul(date.substr(8, 2));
+    days = daysFromCivil(y, m, d);
+    return true;
+}
+
+long todayDays() {
+    time_t now = time(nullptr);
+    tm local = *localtime(&now);
+    return daysFromCivil(local.tm_year + 1900, (unsigned)local.tm_mon + 1, (unsigned)local.tm_mday);
+}
+
+double urgencyScore(const Task& t, long today) {
+    double score = 10.0 * ((int)t.priority + 1);
+
+    long due;
+    if (dateToDays(t.dueDate, due)) {
+        long left = due - today;
+        if (left < 0) score += min(14.0 + (double)(-left), OVERDUE_MAX_POINTS);
+        else if (left < 7) score += 2.0 * (double)(7 - left);
+    }
+
+    if (t.created > 0) {
+        double ageDays = (double)(time(nullptr) - t.created) / 86400.0;
+        score += 0.25 * min(max(ageDays, 0.0), 60.0);
+    }
+    return score;
+}
+
+struct UrgentTask {
+    uint32_t index;   // position in the task list
+    double score;
+};
+
+vector<UrgentTask> topUrgent(const vector<Task>& tasks, size_t count) {
+    long today = todayDays();
+    vector<UrgentTask> open;
+    open.reserve(tasks.size());
+    for (uint32_t i = 0; i < (uint32_t)tasks.size(); ++i) {
+        if (!tasks[i].completed) open.push_back({i, urgencyScore(tasks[i], today)});
+    }
+
+    auto moreUrgent = [](const UrgentTask& a, const UrgentTask& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.index < b.index;
+    };
+    size_t keep = min(count, open.size());
+    nth_element(open.begin(), open.begin() + keep, open.end(), moreUrgent);
+    open.resize(keep);
+    sort(open.begin(), open.end(), moreUrgent);
+    return open;
+}
+
+void showUrgentTasks(const vector<Task>& tasks) {
+    cout << "\n  ========================== MOST URGENT ==========================\n\n";
+
+    string n = readLine("How many (leave empty for " + to_string(URGENT_DEFAULT_COUNT) + "): ");
+    size_t count = URGENT_DEFAULT_COUNT;
+    if (!n.empty()) {
+        char* end = nullptr;
+        long v = strtol(n.c_str(), &end, 10);
+        if (*end != '\0' || v <= 0) {
+            cout << "  " << RED << "[X]" << RESET << " Invalid number.\n";
+            return;
+        }
+        count = (size_t)v;
+    }
+
+    vector<UrgentTask> top = topUrgent(tasks, count);
+    if (top.empty()) {
+        cout << "\n  [i] No open tasks. Nice work!\n";
+        return;
+    }
+
+    cout << '\n';
+    for (const auto& u : top) {
+        char score[32];
+        snprintf(score, sizeof(score), "%.1f", u.score);
+        cout << formatTaskRow(tasks[u.index], displayNumber(tasks, u.index))
+             << "  " << CYAN << "(urgency " << score << ")" << RESET << '\n';
+    }
+    cout << '\n';
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// TABLE VIEW
+// ═══════════════════════════════════════════════════════════════════
+//
+// Column-aligned rows. Each title's terminal width is measured once when the
+// task is added or edited and kept with a histogram of widths, so the title
+// column is sized in O(1) and rows are padded or cut without rescanning.
+
+const size_t TABLE_MIN_TITLE = 10;
+const size_t TABLE_FIXED_COLS = 26;   // indent, number gap, [V], [H], gaps and a 10-char due date
+
+struct TitleWidth {
+    uint16_t cells = 0;
+    bool ascii = true;   // byte offsets are cell offsets, so cutting needs no scan
+};
+
+struct TitleWidths {
+    uint64_t version = 0;
+    vector<TitleWidth> of;    // by task id
+    vector<uint32_t> count;   // titles per width
+    size_t widest = 0;
+};
+
+TitleWidths titleWidths;
+
+// Toggled with 't' in the pager or started with --table
+bool tableLayout = false;
+
+void titleWidthAdd(const Task& t) {
+    TitleWidth w;
+    w.ascii = all_of(t.title.begin(), t.title.end(), [](char c) { return (unsigned char)c < 0x80; });
+    w.cells = (uint16_t)min<size_t>(w.ascii ? t.title.size() : displayWidth(t.title), UINT16_MAX);
+
+    TitleWidths& tw = titleWidths;
+    if (t.id >= tw.of.size()) tw.of.resize(max<size_t>(t.id + 1, tw.of.size() * 2));
+    tw.of[t.id] = w;
+    if (w.cells >= tw.count.size()) tw.count.resize(w.cells + 1);
+    ++tw.count[w.cells];
+    tw.widest = max<size_t>(tw.widest, w.cells);
+}
+
+void titleWidthRemove(const Task& t) {
+    TitleWidths& tw = titleWidths;
+    --tw.count[tw.of[t.id].cells];
+    while (tw.widest > 0 && tw.count[tw.widest] == 0) --tw.widest;
+}
+
+const TitleWidths& ensureTitleWidths(const vector<Task>& tasks) {
+    if (titleWidths.version == storeVersion) return titleWidths;
+    titleWidths = TitleWidths();
+    for (const Task& t : tasks) titleWidthAdd(t);
+    titleWidths.version = storeVersion;
+    return titleWidths;
+}
+
+struct TableColumns {
+    size_t numberWidth;
+    size_t titleWidth;
+};
+
+// Titles get whatever the terminal has left, or their natural width when
+// there is no terminal to fit
+TableColumns tableColumns(const vector<Task>& tasks, int screenCols) {
+    TableColumns cols;
+    cols.numberWidth = to_string(max<size_t>(tasks.size(), 1)).size();
+    cols.titleWidth = max(ensureTitleWidths(tasks).widest, (size_t)5);
+    if (screenCols > 0) {
+        size_t room = (size_t)max(screenCols - (int)(TABLE_FIXED_COLS + cols.numberWidth), 0);
+        cols.titleWidth = min(cols.titleWidth, max(room, TABLE_MIN_TITLE));
+    }
+    return cols;
+}
+
+void appendPadding(string& out, size_t n) {
+    out.append(n, ' ');
+}
+
+// Writes the title in exactly `width` cells, ending cut titles with "…"
+void appendFittedTitle(string& out, const string& title, TitleWidth w, size_t width) {
+    if (w.cells <= width) {
+        out += title;
+        appendPadding(out, width - w.cells);
+        return;
+    }
+
+    size_t keep = width - 1;
+    if (w.ascii) {
+        out.append(title, 0, keep);
+    } else {
+        size_t used = 0, i = 0;
+        while (i < title.size()) {
+            size_t start = i;
+            int cw = codepointWidth(decodeUtf8(title, i));
+            if (used + cw > keep) {
+                i = start;
+                break;
+            }
+            used += cw;
+        }
+        out.append(title, 0, i);
+        appendPadding(out, keep - used);
+    }
+    out += "…";
+}
+
+void appendTableHeader(string& out, const TableColumns& cols) {
+    out += "  ";
+    appendPadding(out, cols.numberWidth - 1);
+    out += "#  Done Pri  Title";
+    appendPadding(out, cols.titleWidth - 5);
+    out += "  Due\n";
+}
+
+void appendTableRow(string& out, const Task& t, size_t number, const TableColumns& cols) {
+    size_t digits = 1;
+    for (size_t v = number; v >= 10; v /= 10) ++digits;
+    out += "  ";
+    appendPadding(out, cols.numberWidth > digits ? cols.numberWidth - digits : 0);
+    appendNumber(out, number);
+
+    out.append(t.completed ? "  [V]  " : "  [ ]  ");
+    appendLiteral(out, PRIORITY_SYMBOLS[outputFormat != OutputFormat::Color][(int)t.priority]);
+    out += "  ";
+    appendFittedTitle(out, t.title, titleWidths.of[t.id], cols.titleWidth);
+    out += "  ";
+    out += t.dueDate.empty() ? "-" : t.dueDate;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// CHANGE NOTIFICATIONS
+// ═══════════════════════════════════════════════════════════════════
+//
+// Mutation paths report what changed so id-keyed structures can be
+// patched in place. Anything that was already stale, or is not patched
+// here, is rebuilt lazily from the new version instead.
+
+// True if a structure was current just before this change; claims the new version for it
+bool patchable(uint64_t& builtAt) {
+    if (builtAt + 1 != storeVersion) return false;
+    builtAt = storeVersion;
+    return true;
+}
+
+void noteTaskAdded(const vector<Task>& tasks, size_t pos) {
+    touchStore();
+    if (patchable(taskIndex.version)) taskIndexAdd(tasks, (uint32_t)pos);
+    if (patchable(textIndex.version)) textIndexAdd(tasks[pos]);
+    if (patchable(positionIndex.version)) positionIndex.of[tasks[pos].id] = (uint32_t)pos;
+    patchable(rowCache.version);   // a fresh id has no cached row yet
+    if (patchable(titleWidths.version)) titleWidthAdd(tasks[pos]);
+    for (auto& v : views) {
+        if (patchable(v.second.version)) viewTaskAdded(v.second, tasks[pos]);
+    }
+}
+
+void noteTaskChanged(const vector<Task>& tasks, size_t pos, const Task& before) {
+    touchStore();
+    if (patchable(taskIndex.version)) taskIndexChange(tasks, (uint32_t)pos, before);
+    if (patchable(rowCache.version)) forgetRowBody(before.id);
+    if (patchable(titleWidths.version) && before.title != tasks[pos].title) {
+        titleWidthRemove(before);
+        titleWidthAdd(tasks[pos]);
+    }
+    if (patchable(textIndex.version) && before.title != tasks[pos].title) {
+        textIndexRemove(before);
+        textIndexAdd(tasks[pos]);
+    }
+    patchable(positionIndex.version);
+    for (auto& v : views) {
+        if (patchable(v.second.version)) viewTaskChanged(v.second, before, tasks[pos]);
+    }
+}
+
+void noteTaskRemoved(const vector<Task>& tasks, size_t pos, const Task& removed) {
+    touchStore();
+    if (patchable(rowCache.version)) forgetRowBody(removed.id);
+    if (patchable(titleWidths.version)) titleWidthRemove(removed);
+    if (patchable(textIndex.version)) textIndexRemove(removed);
+    if (patchable(positionIndex.version)) {
+        positionIndex.of.erase(removed.id);
+        for (size_t i = pos; i < tasks.size(); ++i) positionIndex.of[tasks[i].id] = (uint32_t)i;
+    }
+    for (auto& v : views) {
+        if (patchable(v.second.version)) viewTaskRemoved(v.second, removed);
+    }
+}
+
+// Whole list rewritten (batch mode): everything rebuilds on demand
+void noteTasksReplaced() {
+    touchStore();
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// PAGED LIST
+// ═══════════════════════════════════════════════════════════════════
+
+// Lists are shown one screen at a time. Only the rows on the current page
+// are formatted, so paging through 100k tasks costs the same as through 10,
+// and a Screen redraws just the cells that differ from the previous page.
+
+const int PAGER_CHROME_ROWS = 10;   // title, view line, footer, status and prompt around a page
+const int PAGER_LIST_ROW = 4;
+const size_t PAGER_MIN_ROWS = 5;
+
+size_t pageSize(int screenRows) {
+    return max<size_t>(PAGER_MIN_ROWS, screenRows > PAGER_CHROME_ROWS ? (size_t)(screenRows - PAGER_CHROME_ROWS) : 0);
+}
+
+size_t pageCount(size_t total, size_t size) {
+    return max<size_t>(1, (total + size - 1) / size);
+}
+
+bool showingTable() {
+    return tableLayout && (outputFormat == OutputFormat::Color || outputFormat == OutputFormat::Plain);
+}
+
+// Table pages start with a header line; screenCols 0 means no width limit
+const string& pageRows(const vector<Task>& tasks, size_t first, size_t count, int screenCols) {
+    TableColumns cols = { 0, 0 };
+    string key = string("page:") + OUTPUT_FORMAT_NAMES[(int)outputFormat] + ':' + activeViewKey() + ':' + to_string(first) + ':' + to_string(count);
+    if (showingTable()) {
+        cols = tableColumns(tasks, screenCols);
+        key += ":table:" + to_string(cols.titleWidth);
+    }
+
+    const string* rendered = renderCache.get(key, storeVersion);
+    if (!rendered) {
+        string out;
+        out.reserve((count + 1) * 64);
+        if (showingTable()) appendTableHeader(out, cols);
+        size_t number = first;
+        forEachRow(tasks, first, count, [&](uint32_t i) {
+            if (showingTable()) appendTableRow(out, tasks[i], ++number, cols);
+            else appendTaskRow(out, tasks[i], ++number);
+            out += '\n';
+        });
+        rendered = &renderCache.put(key, storeVersion, move(out));
+    }
+    return *rendered;
+}
+
+string viewLabel(const vector<Task>& tasks) {
+    const TaskView& view = activeView(tasks);
+    if (view.spec.empty() && activeViewName == DEFAULT_VIEW) return "";
+    return "  View: " + activeViewName + " (" + (view.spec.empty() ? "unsorted" : describeSortSpec(view.spec)) + ")";
+}
+
+bool isNumber(const string& s) {
+    return !s.empty() && s.size() <= 9 && all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// "g 12" and "g12" both name page 12
+string pageArg(const string& input) {
+    size_t at = input.find_first_not_of(' ', 1);
+    return at == string::npos ? string() : input.substr(at);
+}
+
+// Piped output gets the whole list in one go, as before paging existed
+int printAllTasks(const vector<Task>& tasks, const string& title, const string& pickVerb) {
+    cout << "\n" << title << "\n\n";
+    string label = viewLabel(tasks);
+    if (!label.empty()) cout << label << "\n\n";
+    writeOutput(pageRows(tasks, 0, tasks.size(), 0));
+    if (pickVerb.empty()) return -1;
+
+    string input = readLine(pickVerb + " which task (number): ");
+    return isNumber(input) ? positionForNumber(tasks, stoi(input)) : -1;
+}
+
+// Pages through the active view under the given title. Enter/n and p move
+// a page, "g N" jumps to page N, t switches between list and table layout
+// and q leaves. A bare number jumps to the
+// page holding that task or, given a pick verb, selects it: the return
+// value is its position, else -1.
+int pageThroughTasks(const vector<Task>& tasks, const string& title, const string& pickVerb) {
+    if (!outputIsTerminal()) return printAllTasks(tasks, title, pickVerb);
+
+    bool picking = !pickVerb.empty();
+    Screen screen(terminalRows(), terminalCols());
+    string status;
+    size_t first = 0;
+    while (true) {
+        if (screen.rows() != terminalRows() || screen.cols() != terminalCols()) {
+            screen = Screen(terminalRows(), terminalCols());
+        }
+        size_t size = pageSize(screen.rows()) - (showingTable() ? 1 : 0);
+        size_t pages = pageCount(tasks.size(), size);
+        first = min(first / size, pages - 1) * size;
+        size_t count = min(size, tasks.size() - first);
+
+        int footerRow = PAGER_LIST_ROW + (int)size + (showingTable() ? 2 : 1);
+        int promptRow = footerRow + 2;
+        screen.clear();
+        screen.draw(1, 0, title);
+        screen.draw(3, 0, viewLabel(tasks));
+        screen.draw(PAGER_LIST_ROW, 0, pageRows(tasks, first, count, screen.cols()));
+        if (pages > 1) {
+            screen.draw(footerRow, 0, "  Page " + to_string(first / size + 1) + " of " + to_string(pages) +
+                        "  (tasks " + to_string(first + 1) + "-" + to_string(first + count) + " of " + to_string(tasks.size()) + ")");
+        }
+        screen.draw(footerRow + 1, 0, status);
+        status.clear();
+
+        if (pages == 1 && !picking) {
+            screen.placeCursor(footerRow + 1, 0);
+            screen.flush();
+            return -1;
+        }
+
+        string paging = pages == 1 ? ", t: table" : ", n/p: page, g N: go to page, t: table, q: quit";
+        int end = screen.draw(promptRow, 0, picking ? "  " + pickVerb + " which task (number" + paging + "): "
+                                                    : "  Jump to (task number" + paging + "): ");
+        screen.placeCursor(promptRow, min(end, screen.cols() - 1));
+        screen.flush();
+
+        string input;
+        bool ended = !stdinInput.readLine(input);
+        screen.invalidateRow(promptRow);   // holds whatever was typed
+        if (ended || input == "q") return -1;
+
+        if (input.empty() || input == "n") {
+            if (first / size + 1 < pages) first += size;
+            else if (!picking || pages == 1) return -1;
+        } else if (input == "p") {
+            if (first >= size) first -= size;
+        } else if (input == "t") {
+            tableLayout = !tableLayout;
+        } else if (input[0] == 'g' && isNumber(pageArg(input))) {
+            size_t page = stoul(pageArg(input));
+            first = (min(max<size_t>(page, 1), pages) - 1) * size;
+        } else if (isNumber(input)) {
+            int number = stoi(input);
+            if (picking) return positionForNumber(tasks, number);
+            if (number >= 1 && (size_t)number <= tasks.size()) first = (number - 1) / size * size;
+            else status = string("  ") + RED + "[X]" + RESET + " No task #" + to_string(number) + ".";
+        } else if (picking) {
+            return -1;
+        } else {
+            status = string("  ") + RED + "[X]" + RESET + " Unknown command.";
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// CORE FEATURE FUNCTIONS
+// ═══════════════════════════════════════════════════════════════════
+
+void displayTasks(const vector<Task>& tasks) {
+    if (tasks.empty()) {
+        cout << "\n  [i] No tasks found. Add one to get started!\n";
+        return;
+    }
+
+    pageThroughTasks(tasks, "  ========================== YOUR TASKS ==========================", "");
+    
+    cout << "\n  ================================================================\n";
+}
+
+void addTask(vector<Task>& tasks) {
+    cout << "\n  ========================= ADD NEW TASK =========================\n\n";
+
+    string title = readLine("Task title: ");
+    
+    if (title.empty()) {
+        cout << "  " << RED << "[X]" << RESET << " Task title cannot be empty.\n";
+        return;
+    }
+    
+    if (taskExists(tasks, title)) {
+        cout << "  " << RED << "[X]" << RESET << " A task with this title already exists.\n";
+        return;
+    }
+
+    int p = readInt("Priority (1 = Low, 2 = Medium, 3 = High): ");
+    string due = readLine("Due date (YYYY-MM-DD or leave empty): ");
+
+    tasks.push_back({title, false, intToPriority(p), due});
+    tasks.back().id = nextTaskId++;
+    tasks.back().created = (int64_t)time(nullptr);
+    noteTaskAdded(tasks, tasks.size() - 1);
+    recordChange(taskChange(nullptr, &tasks.back()));
+    saveTasks(tasks);
+    
+    cout << "  " << GREEN << "[V]" << RESET << " Task added successfully!\n";
+}
+
+void deleteTask(vector<Task>& tasks) {
+    if (tasks.empty()) {
+        cout << "\n  [i] No tasks to delete.\n";
+        return;
+    }
+
+    int idx = pageThroughTasks(tasks, "  ========================== DELETE TASK ==========================", "Delete");
+    
+    if (idx < 0) {
+        cout << "  " << RED << "[X]" << RESET << " Invalid task number.\n";
+        return;
+    }
+
+    string confirm = readLine("Confirm delete (y/n): ");
+    if (confirm.empty() || tolower(confirm[0]) != 'y') {
+        cout << "  " << RED << "[X]" << RESET << " Deletion cancelled.\n";
+        return;
+    }
+
+    Task removed = move(tasks[idx]);
+    tasks.erase(tasks.begin() + idx);
+    noteTaskRemoved(tasks, idx, removed);
+    recordChange(taskChange(&removed, nullptr));
+    saveTasks(tasks);
+    
+    cout << "  " << GREEN << "[V]" << RESET << " Task deleted successfully!\n";
+}
+
+void editTask(vector<Task>& tasks) {
+    if (tasks.empty()) {
+        cout << "\n  [i] No tasks to edit.\n";
+        return;
+    }
+
+    int idx = pageThroughTasks(tasks, "  =========================== EDIT TASK ===========================", "Edit");
+    
+    if (idx < 0) {
+        cout << "  " << RED << "[X]" << RESET << " Invalid task number.\n";
+        return;
+    }
+
+    Task& t = tasks[idx];
+    Task before = t;
+
+    cout << "\n  Current title: " << t.title << '\n';
+    string nt = readLine("New title (leave empty to keep): ");
+    if (!nt.empty() && !taskExists(tasks, nt)) {
+        t.title = nt;
+    }
+
+    string c = readLine("Completed (y/n/leave empty to keep): ");
+    if (!c.empty()) {
+        t.completed = (tolower(c[0]) == 'y');
+    }
+
+    int np = readInt("Priority (1 = Low, 2 = Medium, 3 = High, 0 = keep): ");
+    if (np >= 1 && np <= 3) {
+        t.priority = intToPriority(np);
+    }
+
+    string nd = readLine("Due date (YYYY-MM-DD or leave empty): ");
+    if (!nd.empty()) {
+        t.dueDate = nd;
+    }
+    
+    noteTaskChanged(tasks, idx, before);
+    recordChange(taskChange(&before, &t));
+    saveTasks(tasks);
+    cout << "  " << GREEN << "[V]" << RESET << " Task updated successfully!\n";
+}
+
+void searchTasks(const vector<Task>& tasks) {
+    if (tasks.empty()) {
+        cout << "\n  [i] No tasks to search.\n";
+        return;
+    }
+
+    cout << "\n  ========================== SEARCH TASKS =========================\n\n";
+
+    int mode = readInt("Search mode (1 = Exact, 2 = Fuzzy, 3 = Query, 4 = Live, 5 = Ranked): ");
+    if (mode < 1 || mode > 5) {
+        cout << "  " << RED << "[X]" << RESET << " Invalid option.\n";
+        return;
+    }
+
+    if (mode == 4) {
+        liveSearch(tasks);
+        return;
+    }
+
+    if (mode == 3) {
+        cout << "  Example: priority:H done:no due<2026-11-01 \"budget\"  (prefix with 'explain' to see the plan)\n";
+    }
+
+    string query = readLine("Search query: ");
+    
+    if (query.empty()) {
+        cout << "  " << RED << "[X]" << RESET << " Search query cannot be empty.\n";
+        return;
+    }
+
+    bool explain = false;
+    QueryNode parsed;
+    if (mode == 3) {
+        if (toLower(query.substr(0, 8)) == "explain ") {
+            explain = true;
+            query = query.substr(8);
+        }
+        string error;
+        if (!parseQuery(query, parsed, error)) {
+            cout << "  " << RED << "[X]" << RESET << " " << error << ".\n";
+            return;
+        }
+    }
+
+    cout << "\n  Search results:\n\n";
+    
+    bool cached = false;
+    const QueryResult& res = cachedSearch(tasks, mode, query, parsed, cached);
+    outputBuffer.clear();
+    for (uint32_t i : res.matches) {
+        appendTaskRow(outputBuffer, tasks[i], displayNumber(tasks, i));
+        outputBuffer += '\n';
+    }
+    writeOutput(outputBuffer);
+    bool found = !res.matches.empty();
+
+    if (explain) {
+        cout << "\n  " << CYAN << "[i]" << RESET << " Query: " << describeQuery(parsed) << '\n';
+        cout << "  " << CYAN << "[i]" << RESET << " Plan: " << res.plan << (cached ? " (cached)" : "") << '\n';
+        cout << "  " << CYAN << "[i]" << RESET << " Rows examined: " << (cached ? 0 : res.examined) << " of " << tasks.size()
+             << ", matched: " << res.matches.size() << '\n';
+    }
+    
+    if (!found) {
+        cout << "  [i] No tasks found matching \"" << query << "\"\n";
+    }
+    cout << '\n';
+}
+
+void sortTasks(const vector<Task>& tasks) {
+    if (tasks.empty()) {
+        cout << "\n  [i] No tasks to sort.\n";
+        return;
+    }
+
+    cout << "\n  =========================== SORT TASKS ===========================\n\n";
+
+    cout << "  Active view: " << activeViewName << " (" << (views[activeViewName].spec.empty() ? "unsorted" : describeSortSpec(views[activeViewName].spec)) << ")\n";
+    int opt = readInt("Sort by (1 = Priority, 2 = Completion, 3 = Due date, 4 = Title, 5 = Custom, 6 = Switch view, 7 = Unsorted): ");
+
+    if (opt == 6) {
+        for (const auto& v : views) {
+            cout << "  " << (v.first == activeViewName ? "* " : "  ") << v.first << " ("
+                 << (v.second.spec.empty() ? "unsorted" : describeSortSpec(v.second.spec)) << ")\n";
+        }
+        string name = readLine("Switch to view: ");
+        if (!views.count(name)) {
+            cout << "  " << RED << "[X]" << RESET << " No view named \"" << name << "\".\n";
+            return;
+        }
+        activeViewName = name;
+        saveViews();
+        cout << "  " << GREEN << "[V]" << RESET << " Switched to view " << name << "!\n";
+        return;
+    }
+
+    string specText;
+    switch (opt) {
+        case 1: specText = "priority desc"; break;
+        case 2: specText = "completed asc"; break;
+        case 3: specText = "due asc"; break;
+        case 4: specText = "title asc"; break;
+        case 5: specText = readLine("Sort keys (e.g. priority desc, due asc, title asc): "); break;
+        case 7: break;
+        default:
+            cout << "  " << RED << "[X]" << RESET << " Invalid option.\n";
+            return;
+    }
+
+    SortSpec spec;
+    string error;
+    if (opt != 7 && !parseSortSpec(specText, spec, error)) {
+        cout << "  " << RED << "[X]" << RESET << " " << error << ".\n";
+        return;
+    }
+
+    string name = readLine("Save as view (leave empty for \"" + activeViewName + "\"): ");
+    if (name.empty()) name = activeViewName;
+
+    // Only the view changes: storage order, undo history and tasks.json stay untouched
+    setViewSpec(tasks, name, spec);
+    saveViews();
+
+    if (spec.empty()) {
+        cout << "  " << GREEN << "[V]" << RESET << " View " << name << " shows tasks unsorted!\n";
+    } else {
+        cout << "  " << GREEN << "[V]" << RESET << " View " << name << " sorted by " << describeSortSpec(spec) << "!\n";
+    }
+}
+
+// Puts the task with the id into the given state, or removes it when it
+// should not exist. A task that has to come back goes to the end of the
+// list, as a journaled add does in every other process. Returns the
+// journal op this amounts to, or nullptr if the task was already so.
+const char* restoreTask(vector<Task>& tasks, bool exists, const Task& state, uint32_t id) {
+    const PositionIndex& index = ensurePositionIndex(tasks);
+    auto it = index.of.find(id);
+    int pos = it == index.of.end() ? -1 : (int)it->second;
+    if (exists && pos >= 0) {
+        Task before = tasks[pos];
+        tasks[pos] = state;
+        noteTaskChanged(tasks, pos, before);
+        return "edit";
+    }
+    if (exists) {
+        tasks.push_back(state);
+        noteTaskAdded(tasks, tasks.size() - 1);
+        return "add";
+    }
+    if (pos < 0) return nullptr;
+    Task removed = move(tasks[pos]);
+    tasks.erase(tasks.begin() + pos);
+    noteTaskRemoved(tasks, pos, removed);
+    return "delete";
+}
+
+// Moves the newest change from one history stack to the other and applies
+// the side it leads to; id is the task it touched. The caller checks that
+// the stack is not empty.
+const char* stepHistory(vector<Task>& tasks, bool isUndo, uint32_t& id) {
+    deque<TaskChange>& from = isUndo ? undoStack : redoStack;
+    deque<TaskChange>& to = isUndo ? redoStack : undoStack;
+    const TaskChange& c = from.back();
+    id = c.hadAfter ? c.after.id : c.before.id;
+    const char* op = isUndo ? restoreTask(tasks, c.hadBefore, c.before, id)
+                            : restoreTask(tasks, c.hadAfter, c.after, id);
+    to.push_back(move(from.back()));
+    from.pop_back();
+    return op;
+}
+
+// Only the one task changes, and saveTasks merges it by id, so whatever
+// other processes saved in the meantime stays
+void undo(vector<Task>& tasks) {
+    if (undoStack.empty()) {
+        cout << "\n  " << CYAN << "[i]" << RESET << " Nothing to undo.\n";
+        return;
+    }
+    
+    uint32_t id;
+    if (stepHistory(tasks, true, id)) saveTasks(tasks);
+    
+    cout << "  " << GREEN << "[V]" << RESET << " Undo successful!\n";
+}
+
+void redo(vector<Task>& tasks) {
+    if (redoStack.empty()) {
+        cout << "\n  " << CYAN << "[i]" << RESET << " Nothing to redo.\n";
+        return;
+    }
+    
+    uint32_t id;
+    if (stepHistory(tasks, false, id)) saveTasks(tasks);
+    
+    cout << "  " << GREEN << "[V]" << RESET << " Redo successful!\n";
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// BATCH MODE
+// ═══════════════════════════════════════════════════════════════════
+//
+// `--batch [file]` applies a script of commands (from stdin without a file)
+// to the list in memory and saves once at the end. Tasks are named by their
+// stable id rather than a display number:
+//
+//   add [priority:H|M|L] [due:YYYY-MM-DD] [done:yes|no] title...
+//   edit ID [priority:P] [due:DATE|none] [done:yes|no] [new title...]
+//   complete ID
+//   delete ID
+//   sort SPEC                  e.g. "sort priority desc, due asc"
+//
+// Blank lines and lines starting with # are skipped. A bad line is reported
+// with its number and skipped while the rest still apply. Batches take no
+// undo snapshots, and deleted tasks are only removed from the list at the
+// end, so every command costs O(1) however long the list is.
+
+struct BatchFields {
+    bool hasPriority = false;
+    Priority priority = Priority::Medium;
+    bool hasDue = false;
+    string due;
+    bool hasDone = false;
+    bool done = false;
+    string title;
+};
+
+struct BatchState {
+    unordered_map<uint32_t, size_t> positions;   // by id, including deleted tasks
+    vector<bool> deleted;
+    size_t deletedCount = 0;
+    unordered_set<string> titles;
+    bool sorted = false;
+    SortSpec spec;
+};
+
+// Leading field:value words, then the rest of the line as the title
+bool parseBatchFields(const string& text, BatchFields& f, string& error) {
+    size_t pos = 0;
+    while (true) {
+        pos = text.find_first_not_of(' ', pos);
+        if (pos == string::npos) return true;
+        size_t end = text.find(' ', pos);
+        if (end == string::npos) end = text.size();
+
+        string word = toLower(text.substr(pos, end - pos));
+        size_t colon = word.find(':');
+        string field = colon == string::npos ? "" : word.substr(0, colon);
+        string value = colon == string::npos ? "" : word.substr(colon + 1);
+
+        if (field == "priority" || field == "p") {
+            if (!parsePriorityName(value, f.priority)) {
+                error = "Unknown priority '" + value + "' (use H, M or L)";
+                return false;
+            }
+            f.hasPriority = true;
+        } else if (field == "due") {
+            if (value != "none" && !isDate(value)) {
+                error = "Invalid date '" + value + "' (expected YYYY-MM-DD or none)";
+                return false;
+            }
+            f.hasDue = true;
+            f.due = value == "none" ? "" : value;
+        } else if (field == "done") {
+            if (!parseYesNo(value, f.done)) {
+                error = "Unknown done value '" + value + "' (use yes or no)";
+                return false;
+            }
+            f.hasDone = true;
+        } else {
+            f.title = text.substr(pos);
+            f.title.erase(f.title.find_last_not_of(' ') + 1);
+            return true;
+        }
+        pos = end;
+    }
+}
+
+// Position of a live task with the id at the start of text; the rest of
+// the line is left in rest
+// Reads the task id at the start of text into id and what follows into
+// rest. The id must end at whitespace or the end of the text, so a typo
+// such as "1abc" or "1-2" is an error rather than task 1.
+bool takeTaskId(const string& text, uint32_t& id, string& rest, string& error) {
+    size_t start = text.find_first_not_of(" \t");
+    size_t end = start == string::npos ? string::npos : text.find_first_of(" \t", start);
+    string token = start == string::npos ? "" : text.substr(start, end == string::npos ? string::npos : end - start);
+    uint64_t v = 0;
+    bool digits = !token.empty() && token.size() <= 10 &&
+                  all_of(token.begin(), token.end(), [](char c) { return c >= '0' && c <= '9'; });
+    if (digits) v = stoull(token);
+    if (!digits || v == 0 || v > UINT32_MAX) {
+        error = token.empty() ? "Expected a task id" : "'" + token + "' is not a task id";
+        return false;
+    }
+    id = (uint32_t)v;
+    rest = end == string::npos ? "" : text.substr(end);
+    return true;
+}
+
+bool findBatchTask(const BatchState& b, const string& text, size_t& position, string& rest, string& error) {
+    uint32_t id;
+    if (!takeTaskId(text, id, rest, error)) return false;
+    auto it = b.positions.find(id);
+    if (it == b.positions.end() || b.deleted[it->second]) {
+        error = "No task with id " + to_string(id);
+        return false;
+    }
+    position = it->second;
+    return true;
+}
+
+bool applyBatchLine(vector<Task>& tasks, BatchState& b, const string& line, string& error) {
+    size_t split = line.find(' ');
+    string command = toLower(line.substr(0, split));
+    string args = split == string::npos ? "" : line.substr(split + 1);
+
+    if (command == "add") {
+        BatchFields f;
+        if (!parseBatchFields(args, f, error)) return false;
+        if (f.title.empty()) {
+            error = "Task title cannot be empty";
+            return false;
+        }
+        if (b.titles.count(f.title)) {
+            error = "A task with this title already exists";
+            return false;
+        }
+        Task t;
+        t.title = f.title;
+        t.completed = f.done;
+        t.priority = f.priority;
+        t.dueDate = f.due;
+        t.id = nextTaskId++;
+        t.created = (int64_t)time(nullptr);
+        b.positions[t.id] = tasks.size();
+        b.deleted.push_back(false);
+        b.titles.insert(t.title);
+        tasks.push_back(move(t));
+        return true;
+    }
+
+    if (command == "sort") {
+        if (!parseSortSpec(args, b.spec, error)) return false;
+        b.sorted = true;
+        return true;
+    }
+
+    size_t pos;
+    string rest;
+    if (command != "edit" && command != "complete" && command != "delete") {
+        error = "Unknown command '" + command + "'";
+        return false;
+    }
+    if (!findBatchTask(b, args, pos, rest, error)) return false;
+    Task& t = tasks[pos];
+
+    if (command == "complete") {
+        t.completed = true;
+    } else if (command == "delete") {
+        b.deleted[pos] = true;
+        ++b.deletedCount;
+        b.titles.erase(t.title);
+    } else {
+        BatchFields f;
+        if (!parseBatchFields(rest, f, error)) return false;
+        if (!f.title.empty() && f.title != t.title) {
+            if (b.titles.count(f.title)) {
+                error = "A task with this title already exists";
+                return false;
+            }
+            b.titles.erase(t.title);
+            b.titles.insert(f.title);
+            t.title = f.title;
+        }
+        if (f.hasPriority) t.priority = f.priority;
+        if (f.hasDue) t.dueDate = f.due;
+        if (f.hasDone) t.completed = f.done;
+    }
+    return true;
+}
+
+// Returns the process exit status: 0 when every command applied
+int runBatch(vector<Task>& tasks, const string& path) {
+    ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file.is_open()) {
+            cout << "  " << RED << "[X]" << RESET << " Cannot open " << path << ".\n";
+            return 1;
+        }
+    }
+    auto nextLine = [&](string& line) {
+        if (path == "-") return stdinInput.readLine(line);
+        if (!getline(file, line)) return false;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    };
+
+    BatchState b;
+    b.deleted.assign(tasks.size(), false);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        b.positions[tasks[i].id] = i;
+        b.titles.insert(tasks[i].title);
+    }
+
+    string line, error;
+    size_t lineNumber = 0, applied = 0, failed = 0;
+    while (nextLine(line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == string::npos || line[start] == '#') continue;
+        if (applyBatchLine(tasks, b, line.substr(start), error)) {
+            ++applied;
+        } else {
+            ++failed;
+            cout << "  " << RED << "[X]" << RESET << " Line " << lineNumber << ": " << error << ".\n";
+        }
+    }
+
+    if (b.deletedCount > 0) {
+        size_t kept = 0;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            if (b.deleted[i]) continue;
+            if (kept != i) tasks[kept] = move(tasks[i]);   // moving onto itself would empty it
+            ++kept;
+        }
+        tasks.resize(kept);
+    }
+    noteTasksReplaced();
+
+    if (applied > 0) saveTasks(tasks);
+    if (b.sorted) {
+        setViewSpec(tasks, activeViewName, b.spec);
+        saveViews();
+    }
+
+    cout << "  " << (failed ? YELLOW : GREEN) << (failed ? "[!]" : "[V]") << RESET << " Applied " << applied
+         << " of " << applied + failed << " commands; " << tasks.size() << " tasks saved.\n";
+    return failed ? 1 : 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// SERVICE OPERATIONS
+// ═══════════════════════════════════════════════════════════════════
+//
+// Changes made on behalf of the daemon and --stdio-rpc. Each notifies the
+// derived structures the way the menu does and queues a journal entry. The
+// requests that arrive together form a batch: endBatch appends their
+// entries in one write before anything is replied. Undo works per request,
+// whatever batch it arrived in, so a client sees the same history however
+// its writes were split into reads. Rather than a snapshot of the whole
+// list, which per request would dominate a pipelined sync, each request
+// keeps the one task it changed.
+
+const size_t JOURNAL_COMPACT_MIN = 1000;
+
+string journalQueue;           // entries not yet appended to tasks.journal
+vector<uint32_t> journalQueueIds;   // the tasks they change
+size_t journaledChanges = 0;   // entries in tasks.journal since the last full save
+
+// Position of the task with the id, or -1
+int taskPosition(const vector<Task>& tasks, uint32_t id) {
+    const PositionIndex& index = ensurePositionIndex(tasks);
+    auto it = index.of.find(id);
+    return it == index.of.end() ? -1 : (int)it->second;
+}
+
+json journalTask(const char* op, const Task& t) {
+    json entry = taskToJson(t);
+    entry["op"] = op;
+    entry["format"] = STORE_FORMAT;
+    return entry;
+}
+
+void queueJournal(const json& entry) {
+    journalQueue += entry.dump();
+    journalQueue += '\n';
+    journalQueueIds.push_back(entry.value("id", 0u));
+    ++journaledChanges;
+}
+
+void saveAllTasks(vector<Task>& tasks) {
+    saveTasks(tasks);
+    journalQueue.clear();
+    journalQueueIds.clear();
+    journaledChanges = 0;
+}
+
+// The journal is folded into tasks.json once it holds a quarter as many
+// entries as the list has tasks, so rewriting the file stays a small share
+// of the work while replaying the journal stays cheap. If another process
+// wrote since the last sync, the merged list is written whole instead.
+void endBatch(vector<Task>& tasks) {
+    if (journalQueue.empty()) return;
+
+    StoreLock lock(true);
+    bool merged = mergeConcurrentChanges(tasks);
+    bool compact = journaledChanges >= max(JOURNAL_COMPACT_MIN, tasks.size() / 4);
+    if (merged || compact || !appendJournalText(journalQueue)) {
+        writeTasksLocked(tasks);
+        journaledChanges = 0;
+    } else {
+        syncedStamp.journalSize = fileSize("tasks.journal");
+        for (uint32_t id : journalQueueIds) {
+            int pos = taskPosition(tasks, id);
+            if (pos < 0) syncedHashes.erase(id);
+            else syncedHashes[id] = taskHash(tasks[pos]);
+        }
+    }
+    journalQueue.clear();
+    journalQueueIds.clear();
+}
+
+bool serviceAdd(vector<Task>& tasks, const BatchFields& f, string& error) {
+    if (f.title.empty()) {
+        error = "Task title cannot be empty";
+        return false;
+    }
+    if (taskExists(tasks, f.title)) {
+        error = "A task with this title already exists";
+        return false;
+    }
+    Task t;
+    t.title = f.title;
+    t.completed = f.done;
+    t.priority = f.priority;
+    t.dueDate = f.due;
+    t.id = nextTaskId++;
+    t.created = (int64_t)time(nullptr);
+    tasks.push_back(t);
+    noteTaskAdded(tasks, tasks.size() - 1);
+    queueJournal(journalTask("add", t));
+    recordChange(taskChange(nullptr, &t));
+    return true;
+}
+
+bool serviceEdit(vector<Task>& tasks, size_t pos, const BatchFields& f, string& error) {
+    if (!f.title.empty() && f.title != tasks[pos].title && taskExists(tasks, f.title)) {
+        error = "A task with this title already exists";
+        return false;
+    }
+    Task& t = tasks[pos];
+    Task before = t;
+    if (!f.title.empty()) t.title = f.title;
+    if (f.hasPriority) t.priority = f.priority;
+    if (f.hasDue) t.dueDate = f.due;
+    if (f.hasDone) t.completed = f.done;
+    noteTaskChanged(tasks, pos, before);
+    queueJournal(journalTask("edit", t));
+    recordChange(taskChange(&before, &t));
+    return true;
+}
+
+void serviceDelete(vector<Task>& tasks, size_t pos) {
+    Task removed = move(tasks[pos]);
+    tasks.erase(tasks.begin() + pos);
+    noteTaskRemoved(tasks, pos, removed);
+    queueJournal({{"op", "delete"}, {"id", removed.id}});
+    recordChange(taskChange(&removed, nullptr));
+}
+
+// Undo or redo of the last request that changed a task, journaled like
+// any other change
+bool serviceHistory(vector<Task>& tasks, bool isUndo, string& error) {
+    if ((isUndo ? undoStack : redoStack).empty()) {
+        error = isUndo ? "Nothing to undo" : "Nothing to redo";
+        return false;
+    }
+    uint32_t id;
+    const char* op = stepHistory(tasks, isUndo, id);
+    if (!op) return true;
+    if (strcmp(op, "delete") == 0) queueJournal({{"op", "delete"}, {"id", id}});
+    else queueJournal(journalTask(op, tasks[taskPosition(tasks, id)]));
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// DAEMON
+// ═══════════════════════════════════════════════════════════════════
+//
+// `--daemon` keeps the list, its indexes and the undo history in memory and
+// answers requests on the Unix domain socket tasks.sock in the working
+// directory. A request is one line:
+//
+//   add [priority:P] [due:DATE] [done:yes|no] title...
+//   edit ID [priority:P] [due:DATE|none] [done:yes|no] [new title...]
+//   done ID | delete ID | list | search QUERY | undo | redo | ping | stop
+//
+// optionally preceded by "--format NAME", which the reply is rendered in;
+// clients send the format they detected for their own stdout.
+//
+// and the reply is "OK <length>\n" followed by that many bytes of output, or
+// "ERR <message>\n". A connection may send any number of requests; those
+// that arrive together are answered together, after one journal append.
+//
+// `--client REQUEST...` sends one request and prints the reply. The one-shot
+// commands go through a running daemon too, so it never works from a stale
+// copy of the list.
+
+const char* DAEMON_SOCKET = "tasks.sock";
+const size_t DAEMON_MAX_REQUEST = 64 * 1024;
+
+bool daemonStopRequested = false;
+
+string okLine(const string& text) {
+    return string("  ") + GREEN + "[V]" + RESET + " " + text + "\n";
+}
+
+// Position of the task with the id at the start of text, or -1; the rest
+// of the line is left in rest
+int requestTask(const vector<Task>& tasks, const string& text, string& rest, string& error) {
+    uint32_t id;
+    if (!takeTaskId(text, id, rest, error)) return -1;
+    int pos = taskPosition(tasks, id);
+    if (pos < 0) error = "No task with id " + to_string(id);
+    return pos;
+}
+
+// Runs one request against the resident list. On success reply holds the
+// output; otherwise it holds the error message.
+bool serveCommand(vector<Task>& tasks, const string& line, string& reply) {
+    size_t split = line.find(' ');
+    string command = toLower(line.substr(0, split));
+    string args = split == string::npos ? "" : line.substr(split + 1);
+    reply.clear();
+
+    if (command == "ping") {
+        reply = "pong\n";
+        return true;
+    }
+    if (command == "stop") {
+        daemonStopRequested = true;
+        reply = okLine("Daemon stopping.");
+        return true;
+    }
+
+    if (command == "list") {
+        reply = tasks.empty() ? string("  [i] No tasks found.\n") : pageRows(tasks, 0, tasks.size(), 0);
+        return true;
+    }
+
+    if (command == "search") {
+        if (args.empty()) {
+            reply = "Search query cannot be empty";
+            return false;
+        }
+        QueryNode parsed;
+        if (!parseQuery(args, parsed, reply)) return false;
+        bool cached;
+        const QueryResult& res = cachedSearch(tasks, 3, args, parsed, cached);
+        for (uint32_t i : res.matches) {
+            appendTaskRow(reply, tasks[i], displayNumber(tasks, i));
+            reply += '\n';
+        }
+        if (res.matches.empty()) reply = "  [i] No tasks found matching \"" + args + "\"\n";
+        return true;
+    }
+
+    if (command == "undo" || command == "redo") {
+        bool isUndo = command == "undo";
+        if (!serviceHistory(tasks, isUndo, reply)) return false;
+        reply = okLine(isUndo ? "Undo successful!" : "Redo successful!");
+        return true;
+    }
+
+    if (command == "add") {
+        BatchFields f;
+        if (!parseBatchFields(args, f, reply) || !serviceAdd(tasks, f, reply)) return false;
+        reply = okLine("Task " + to_string(tasks.back().id) + " added successfully!");
+        return true;
+    }
+
+    if (command != "edit" && command != "done" && command != "delete") {
+        reply = "Unknown request '" + command + "'";
+        return false;
+    }
+
+    string rest;
+    int pos = requestTask(tasks, args, rest, reply);
+    if (pos < 0) return false;
+    uint32_t id = tasks[pos].id;
+
+    if (command == "delete") {
+        serviceDelete(tasks, pos);
+        reply = okLine("Task " + to_string(id) + " deleted successfully!");
+        return true;
+    }
+
+    BatchFields f;
+    if (command == "edit") {
+        if (!parseBatchFields(rest, f, reply)) return false;
+    } else {
+        f.hasDone = true;
+        f.done = true;
+    }
+    if (!serviceEdit(tasks, pos, f, reply)) return false;
+    reply = okLine("Task " + to_string(id) + (command == "done" ? " completed!" : " updated successfully!"));
+    return true;
+}
+
+// serveCommand in the format the request names, or the daemon's own
+bool serveRequest(vector<Task>& tasks, const string& line, string& reply) {
+    if (line.compare(0, 9, "--format ") != 0) return serveCommand(tasks, line, reply);
+
+    size_t end = line.find(' ', 9);
+    OutputFormat format, daemonFormat = outputFormat;
+    if (!parseOutputFormat(line.substr(9, end == string::npos ? string::npos : end - 9), format)) {
+        reply = "Unknown format; use color, plain, tsv or jsonl";
+        return false;
+    }
+    useOutputFormat(format);
+    bool ok = serveCommand(tasks, end == string::npos ? "" : line.substr(end + 1), reply);
+    useOutputFormat(daemonFormat);
+    return ok;
+}
+
+#ifdef _WIN32
+
+int runDaemon() {
+    cout << "  " << RED << "[X]" << RESET << " --daemon is not supported on Windows.\n";
+    return 1;
+}
+
+bool daemonRequest(const string&, string&, bool&) {
+    return false;
+}
+
+#else
+
+volatile sig_atomic_t daemonSignaled = 0;
+
+void onDaemonSignal(int) {
+    daemonSignaled = 1;
+}
+
+int connectDaemon() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, DAEMON_SOCKET, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
     }
+    return fd;
 }
 
-string readLine(const string& prompt) {
-    cout << "  " << prompt;
-    string s;
-    getline(cin, s);
-    return s;
+bool writeAll(int fd, const string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
 }
 
-void saveState(const vector<Task>& tasks) {
-    undoStack.push(tasks);
-    while (!redoStack.empty()) redoStack.pop();
-}
+struct DaemonClient {
+    int fd;
+    string pending;   // bytes received after the last complete request
+};
 
-// ═══════════════════════════════════════════════════════════════════
-// FILE STORAGE FUNCTIONS
-// ═══════════════════════════════════════════════════════════════════
+// Answers every complete line in c.pending; false once the connection
+// should be dropped
+bool serveClient(vector<Task>& tasks, DaemonClient& c) {
+    size_t start = 0, newline;
+    string responses, reply;
+    if (c.pending.find('\n') != string::npos) syncWithStore(tasks);
+    while ((newline = c.pending.find('\n', start)) != string::npos) {
+        string line = c.pending.substr(start, newline - start);
+        start = newline + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
 
-void saveTasks(const vector<Task>& tasks) {
-    json j;
-    j["tasks"] = json::array();
+        if (serveRequest(tasks, line, reply)) {
+            responses += "OK " + to_string(reply.size()) + "\n";
+            responses += reply;
+        } else {
+            responses += "ERR " + reply + "\n";
+        }
+    }
+    c.pending.erase(0, start);
+    endBatch(tasks);
+    if (!writeAll(c.fd, responses)) return false;
+    return c.pending.size() <= DAEMON_MAX_REQUEST;
+}
 
-    for (const auto& t : tasks) {
-        j["tasks"].push_back({
-            {"title", t.title},
-            {"completed", t.completed},
-            {"priority", (int)t.priority},
-            {"dueDate", t.dueDate}
-        });
+int runDaemon() {
+    int existing = connectDaemon();
+    if (existing >= 0) {
+        close(existing);
+        cout << "  " << RED << "[X]" << RESET << " A daemon is already serving " << DAEMON_SOCKET << ".\n";
+        return 1;
     }
 
-    ofstream file("tasks.json");
-    if (file.is_open()) {
-        file << j.dump(4);
+    // Nothing answered, so any socket file left behind is stale
+    unlink(DAEMON_SOCKET);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, DAEMON_SOCKET, sizeof(addr.sun_path) - 1);
+    if (listener < 0 || ::bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 16) < 0) {
+        cout << "  " << RED << "[X]" << RESET << " Cannot listen on " << DAEMON_SOCKET << ": " << strerror(errno) << ".\n";
+        if (listener >= 0) close(listener);
+        return 1;
     }
-}
 
-void loadTasks(vector<Task>& tasks) {
-    ifstream file("tasks.json");
-    if (!file.is_open()) return;
+    vector<Task> tasks;
+    loadTasks(tasks);
+    loadViews();
+    activeView(tasks);
+    ensureTaskIndex(tasks);
+    ensurePositionIndex(tasks);
 
-    json j;
+    // No SA_RESTART: a signal has to break the poll below
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onDaemonSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);
 
-    try {
-        file >> j;
-    } catch (...) {
-        cout << "  " << YELLOW << "[!]" << RESET << " Invalid JSON file. Starting fresh.\n";
-        return;
-    }
+    cout << "  " << GREEN << "[V]" << RESET << " Serving " << tasks.size() << " tasks on " << DAEMON_SOCKET
+         << " (Ctrl+C or the stop request ends it).\n" << flush;
 
-    if (j.contains("tasks") && j["tasks"].is_array()) {
-        for (const auto& item : j["tasks"]) {
-            Task task;
-            task.title = item.value("title", "");
-            task.completed = item.value("completed", false);
-            task.priority = intToPriority(item.value("priority", 2));
-            task.dueDate = item.value("dueDate", "");
+    vector<DaemonClient> clients;
+    vector<pollfd> fds;
+    char chunk[1 << 16];
+    while (!daemonSignaled && !daemonStopRequested) {
+        fds.assign(1, {listener, POLLIN, 0});
+        for (const auto& c : clients) fds.push_back({c.fd, POLLIN, 0});
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
 
-            if (!task.title.empty()) {
-                tasks.push_back(task);
+        // Walk backwards so dropping a client keeps the remaining indexes valid
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (!fds[i + 1].revents) continue;
+            ssize_t n = read(clients[i].fd, chunk, sizeof(chunk));
+            bool keep = n > 0 || (n < 0 && errno == EINTR);
+            if (n > 0) {
+                clients[i].pending.append(chunk, (size_t)n);
+                keep = serveClient(tasks, clients[i]);
             }
+            if (!keep) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd >= 0) clients.push_back({fd, ""});
         }
     }
+
+    for (const auto& c : clients) close(c.fd);
+    close(listener);
+    unlink(DAEMON_SOCKET);
+    if (journaledChanges > 0) saveAllTasks(tasks);
+    cout << "  " << GREEN << "[V]" << RESET << " Daemon stopped.\n";
+    return 0;
 }
 
-// ═══════════════════════════════════════════════════════════════════
-// UTILITY FUNCTIONS
-// ═══════════════════════════════════════════════════════════════════
+// Sends one request to a running daemon. False when none answers;
+// otherwise ok tells whether it succeeded and reply holds its output or
+// error message.
+bool daemonRequest(const string& request, string& reply, bool& ok) {
+    int fd = connectDaemon();
+    if (fd < 0) return false;
 
-bool taskExists(const vector<Task>& tasks, const string& title) {
-    for (const auto& t : tasks) {
-        if (t.title == title) {
-            return true;
+    string line = string("--format ") + OUTPUT_FORMAT_NAMES[(int)outputFormat] + " " + request;
+    replace(line.begin(), line.end(), '\n', ' ');
+    string received;
+    size_t header = string::npos;
+    bool answered = writeAll(fd, line + "\n");
+    char chunk[1 << 16];
+    while (answered) {
+        header = received.find('\n');
+        if (header != string::npos && received.compare(0, 3, "OK ") == 0) {
+            size_t length = strtoul(received.c_str() + 3, nullptr, 10);
+            if (received.size() >= header + 1 + length) break;
+        } else if (header != string::npos) {
+            break;
         }
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) answered = false;
+        else received.append(chunk, (size_t)n);
     }
-    return false;
+    close(fd);
+
+    if (!answered) {
+        ok = false;
+        reply = "The daemon closed the connection";
+    } else if (received.compare(0, 3, "OK ") == 0) {
+        ok = true;
+        reply = received.substr(header + 1);
+    } else {
+        ok = false;
+        reply = received.compare(0, 4, "ERR ") == 0 ? received.substr(4, header - 4) : "Malformed reply from the daemon";
+    }
+    return true;
+}
+
+#endif
+
+// Prints the outcome of a request the daemon answered; returns the exit status
+int printDaemonReply(bool ok, const string& reply) {
+    if (!ok) {
+        cout << "  " << RED << "[X]" << RESET << " " << reply << ".\n";
+        return 1;
+    }
+    writeOutput(reply);
+    return 0;
 }
 
-string getPrioritySymbol(Priority p) {
-    if (p == Priority::High) return RED "[H]" RESET;
-    if (p == Priority::Medium) return YELLOW "[M]" RESET;
-    return GREEN "[L]" RESET;
+int runClient(const vector<string>& args) {
+    string request;
+    for (size_t i = 1; i < args.size(); ++i) request += (i > 1 ? " " : "") + args[i];
+    string reply;
+    bool ok;
+    if (!daemonRequest(request, reply, ok)) {
+        cout << "  " << RED << "[X]" << RESET << " No daemon is running here (start one with --daemon).\n";
+        return 1;
+    }
+    return printDaemonReply(ok, reply);
 }
 
 // ═══════════════════════════════════════════════════════════════════
-// CORE FEATURE FUNCTIONS
+// STDIO RPC
 // ═══════════════════════════════════════════════════════════════════
+//
+// `--stdio-rpc` serves editor integrations: one JSON request per line on
+// stdin, one JSON response per line on stdout, with JSON-RPC 2.0 ids and
+// error codes:
+//
+//   {"id": 1, "method": "search", "params": {"query": "priority:H done:no"}}
+//   {"jsonrpc":"2.0","id":1,"result":{"tasks":[{"number":1,"id":7,...}]}}
+//
+// Methods: list, search {query}, add {title, priority?, dueDate?, completed?},
+// edit {id, title?, priority?, dueDate?, completed?}, delete {id}, undo and
+// redo. Tasks come back as in --format jsonl. Requests are answered in
+// order (notifications, without an id, are not), and a client may send many before reading a reply: everything
+// already received is answered in one write, after one journal append that
+// covers all of its changes.
 
-void displayTasks(const vector<Task>& tasks) {
-    if (tasks.empty()) {
-        cout << "\n  [i] No tasks found. Add one to get started!\n";
-        return;
-    }
+const int RPC_PARSE_ERROR = -32700;
+const int RPC_INVALID_REQUEST = -32600;
+const int RPC_METHOD_NOT_FOUND = -32601;
+const int RPC_INVALID_PARAMS = -32602;
 
-    cout << "\n  ========================== YOUR TASKS ==========================\n\n";
+struct RpcError {
+    int code;
+    string message;
+};
 
-    for (size_t i = 0; i < tasks.size(); ++i) {
-        cout << "  " << i + 1 << ". ";
-        
-        if (tasks[i].completed) {
-            cout << "[V] ";
-        } else {
-            cout << "[ ] ";
-        }
-        
-        cout << getPrioritySymbol(tasks[i].priority) << " " << tasks[i].title;
-        
-        if (!tasks[i].dueDate.empty()) {
-            cout << " (Due: " << tasks[i].dueDate << ")";
-        }
-        cout << '\n';
+void appendRpcTasks(string& out, const vector<Task>& tasks, const vector<uint32_t>& positions) {
+    out.append("{\"tasks\":[");
+    for (size_t k = 0; k < positions.size(); ++k) {
+        if (k > 0) out += ',';
+        out.append("{\"number\":");
+        appendNumber(out, displayNumber(tasks, positions[k]));
+        appendJsonBody(out, tasks[positions[k]]);
     }
-    
-    cout << "\n  ================================================================\n";
+    out.append("]}");
 }
 
-void addTask(vector<Task>& tasks) {
-    cout << "\n  ========================= ADD NEW TASK =========================\n\n";
-
-    string title = readLine("Task title: ");
-    
-    if (title.empty()) {
-        cout << "  " << RED << "[X]" << RESET << " Task title cannot be empty.\n";
-        return;
+// Reads the optional task fields of add and edit
+bool rpcFields(const json& params, BatchFields& f, RpcError& err) {
+    err = {RPC_INVALID_PARAMS, ""};
+    if (params.contains("title")) {
+        if (!params["title"].is_string()) err.message = "title must be a string";
+        else f.title = params["title"].get<string>();
     }
-    
-    if (taskExists(tasks, title)) {
-        cout << "  " << RED << "[X]" << RESET << " A task with this title already exists.\n";
-        return;
+    if (err.message.empty() && params.contains("priority")) {
+        if (!params["priority"].is_string() || !parsePriorityName(toLower(params["priority"].get<string>()), f.priority)) {
+            err.message = "priority must be H, M or L";
+        }
+        f.hasPriority = true;
     }
+    if (err.message.empty() && params.contains("dueDate")) {
+        if (!params["dueDate"].is_string()) {
+            err.message = "dueDate must be a string";
+        } else {
+            f.due = params["dueDate"].get<string>();
+            if (!f.due.empty() && !isDate(f.due)) err.message = "dueDate must be YYYY-MM-DD or empty";
+        }
+        f.hasDue = true;
+    }
+    if (err.message.empty() && params.contains("completed")) {
+        if (!params["completed"].is_boolean()) err.message = "completed must be true or false";
+        else f.done = params["completed"].get<bool>();
+        f.hasDone = true;
+    }
+    return err.message.empty();
+}
 
-    int p = readInt("Priority (1 = Low, 2 = Medium, 3 = High): ");
-    string due = readLine("Due date (YYYY-MM-DD or leave empty): ");
-
-    saveState(tasks);
-    tasks.push_back({title, false, intToPriority(p), due});
-    saveTasks(tasks);
-    
-    cout << "  " << GREEN << "[V]" << RESET << " Task added successfully!\n";
+int rpcTaskPosition(const vector<Task>& tasks, const json& params, RpcError& err) {
+    if (!params.contains("id") || !params["id"].is_number_unsigned() || params["id"].get<uint64_t>() > UINT32_MAX) {
+        err = {RPC_INVALID_PARAMS, "id must be a task id"};
+        return -1;
+    }
+    uint32_t id = params["id"].get<uint32_t>();
+    int pos = taskPosition(tasks, id);
+    if (pos < 0) err = {RPC_INVALID_PARAMS, "No task with id " + to_string(id)};
+    return pos;
 }
 
-void deleteTask(vector<Task>& tasks) {
-    if (tasks.empty()) {
-        cout << "\n  [i] No tasks to delete.\n";
-        return;
+// Runs one call; on success result holds its JSON text
+bool rpcCall(vector<Task>& tasks, const string& method, const json& params, string& result, RpcError& err) {
+    if (method == "list") {
+        vector<uint32_t> positions;
+        positions.reserve(tasks.size());
+        forEachRow(tasks, 0, tasks.size(), [&](uint32_t i) { positions.push_back(i); });
+        appendRpcTasks(result, tasks, positions);
+        return true;
     }
 
-    cout << "\n  ========================== DELETE TASK ==========================\n\n";
+    if (method == "search") {
+        if (!params.contains("query") || !params["query"].is_string() || params["query"].get<string>().empty()) {
+            err = {RPC_INVALID_PARAMS, "query must be a non-empty string"};
+            return false;
+        }
+        string query = params["query"].get<string>();
+        QueryNode parsed;
+        err.code = RPC_INVALID_PARAMS;
+        if (!parseQuery(query, parsed, err.message)) return false;
+        bool cached;
+        appendRpcTasks(result, tasks, cachedSearch(tasks, 3, query, parsed, cached).matches);
+        return true;
+    }
 
-    displayTasks(tasks);
-    
-    int idx = readInt("Delete which task (number): ") - 1;
-    
-    if (idx < 0 || idx >= (int)tasks.size()) {
-        cout << "  " << RED << "[X]" << RESET << " Invalid task number.\n";
-        return;
+    if (method == "undo" || method == "redo") {
+        err.code = RPC_INVALID_REQUEST;
+        if (!serviceHistory(tasks, method == "undo", err.message)) return false;
+        result = "{\"count\":" + to_string(tasks.size()) + "}";
+        return true;
     }
 
-    string confirm = readLine("Confirm delete (y/n): ");
-    if (confirm.empty() || tolower(confirm[0]) != 'y') {
-        cout << "  " << RED << "[X]" << RESET << " Deletion cancelled.\n";
-        return;
+    BatchFields f;
+    if (method == "add") {
+        if (!rpcFields(params, f, err)) return false;
+        if (!serviceAdd(tasks, f, err.message)) return false;
+        result = "{\"id\":" + to_string(tasks.back().id) + "}";
+        return true;
     }
 
-    saveState(tasks);
-    tasks.erase(tasks.begin() + idx);
-    saveTasks(tasks);
-    
-    cout << "  " << GREEN << "[V]" << RESET << " Task deleted successfully!\n";
+    if (method != "edit" && method != "delete") {
+        err = {RPC_METHOD_NOT_FOUND, "Unknown method '" + method + "'"};
+        return false;
+    }
+
+    int pos = rpcTaskPosition(tasks, params, err);
+    if (pos < 0) return false;
+    result = "{\"id\":" + to_string(tasks[pos].id) + "}";
+    if (method == "delete") {
+        serviceDelete(tasks, pos);
+        return true;
+    }
+    return rpcFields(params, f, err) && serviceEdit(tasks, pos, f, err.message);
 }
 
-void editTask(vector<Task>& tasks) {
-    if (tasks.empty()) {
-        cout << "\n  [i] No tasks to edit.\n";
-        return;
+// Requests without an id are notifications: they run, but get no reply
+void appendRpcResponse(string& out, vector<Task>& tasks, const string& line) {
+    json request;
+    json id = nullptr;
+    string result;
+    RpcError err{0, ""};
+    bool ok = false, notification = false;
+
+    try {
+        request = json::parse(line);
+    } catch (...) {
+        err = {RPC_PARSE_ERROR, "Request is not valid JSON"};
+    }
+    if (err.code == 0) {
+        if (request.is_object() && request.contains("id")) id = request["id"];
+        const json params = request.is_object() && request.contains("params") ? request["params"] : json::object();
+        bool named = request.is_object() && request.contains("method") && request["method"].is_string();
+        notification = named && !request.contains("id");
+        if (!named) {
+            err = {RPC_INVALID_REQUEST, "Request needs a method name"};
+        } else if (!params.is_object()) {
+            err = {RPC_INVALID_PARAMS, "params must be an object"};
+        } else {
+            ok = rpcCall(tasks, request["method"].get<string>(), params, result, err);
+        }
     }
+    if (notification) return;
 
-    cout << "\n  =========================== EDIT TASK ===========================\n\n";
+    out.append("{\"jsonrpc\":\"2.0\",\"id\":");
+    out += id.dump();
+    if (ok) {
+        out.append(",\"result\":");
+        out += result;
+    } else {
+        out.append(",\"error\":{\"code\":");
+        out += to_string(err.code);
+        out.append(",\"message\":");
+        appendJsonString(out, err.message);
+        out += '}';
+    }
+    out.append("}\n");
+}
 
-    displayTasks(tasks);
-    
-    int idx = readInt("Edit which task (number): ") - 1;
-    
-    if (idx < 0 || idx >= (int)tasks.size()) {
-        cout << "  " << RED << "[X]" << RESET << " Invalid task number.\n";
-        return;
+int runStdioRpc() {
+    // stdout carries only responses; loader warnings go to stderr
+    streambuf* console = cout.rdbuf(cerr.rdbuf());
+    vector<Task> tasks;
+    loadTasks(tasks);
+    loadViews();
+    cout.rdbuf(console);
+
+    string line, responses;
+    while (true) {
+        // Answer what has arrived before waiting for more
+        if (!stdinInput.lineBuffered() && !responses.empty()) {
+            endBatch(tasks);
+            writeOutput(responses);
+            responses.clear();
+        }
+        if (!stdinInput.readLine(line)) break;
+        if (line.find_first_not_of(" \t") == string::npos) continue;
+        if (responses.empty()) syncWithStore(tasks);   // a new batch starts
+        appendRpcResponse(responses, tasks, line);
     }
+    endBatch(tasks);
+    writeOutput(responses);
+    return 0;
+}
 
-    saveState(tasks);
-    Task& t = tasks[idx];
+// ═══════════════════════════════════════════════════════════════════
+// ONE-SHOT COMMANDS
+// ═══════════════════════════════════════════════════════════════════
+//
+// `todo add [priority:P] [due:DATE] title...`, `todo done ID`, `todo list`
+// and `todo search QUERY` run one command and exit, skipping the banner and
+// the menu. add and done only append to the journal, so their cost does not
+// depend on the size of the list; list and search load it but build nothing
+// beyond what they print.
 
-    cout << "\n  Current title: " << t.title << '\n';
-    string nt = readLine("New title (leave empty to keep): ");
-    if (!nt.empty() && !taskExists(tasks, nt)) {
-        t.title = nt;
+// Calls fn with every value stored under an "id" key. The pattern cannot
+// occur inside a string, where the quotes would be escaped.
+template <typename F>
+void forEachStoredId(const string& text, F fn) {
+    size_t pos = 0;
+    while ((pos = text.find("\"id\"", pos)) != string::npos) {
+        pos += 4;
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == ':')) ++pos;
+        uint64_t id = 0;
+        size_t digits = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && digits < 10) {
+            id = id * 10 + (uint64_t)(text[pos++] - '0');
+            ++digits;
+        }
+        if (digits > 0 && id <= UINT32_MAX) fn((uint32_t)id);
     }
+}
 
-    string c = readLine("Completed (y/n/leave empty to keep): ");
-    if (!c.empty()) {
-        t.completed = (tolower(c[0]) == 'y');
+// Next free id without loading the list: the stored counter, or a scan of
+// the ids in a file from before it was stored, and anything journaled since
+uint32_t peekNextTaskId() {
+    uint32_t next = max<uint32_t>(1, (uint32_t)storedCounter("nextId"));
+    string text;
+    if (next == 1 && readWholeFile("tasks.json", text)) {
+        forEachStoredId(text, [&](uint32_t id) { next = max(next, id + 1); });
     }
+    if (readWholeFile("tasks.journal", text)) {
+        forEachStoredId(text, [&](uint32_t id) { next = max(next, id + 1); });
+    }
+    return next;
+}
 
-    int np = readInt("Priority (1 = Low, 2 = Medium, 3 = High, 0 = keep): ");
-    if (np >= 1 && np <= 3) {
-        t.priority = intToPriority(np);
+// Offset of the next "id" key holding exactly the id, at or after from, or
+// npos. strstr is safe because stored JSON never holds a raw NUL.
+size_t findStoredId(const string& text, const string& needle, size_t from) {
+    for (const char* at = strstr(text.c_str() + from, needle.c_str()); at; at = strstr(at + 1, needle.c_str())) {
+        char next = at[needle.size()];
+        if (next < '0' || next > '9') return (size_t)(at - text.c_str());
     }
+    return string::npos;
+}
 
-    string nd = readLine("Due date (YYYY-MM-DD or leave empty): ");
-    if (!nd.empty()) {
-        t.dueDate = nd;
+// Looks for the id as saveTasks writes it ("id": N), then replays the
+// journal entries ("id":N) that name it, so a later delete hides the task
+// again. Only those lines are parsed.
+bool storedTaskExists(uint32_t id) {
+    string text;
+    bool exists = readWholeFile("tasks.json", text) && findStoredId(text, "\"id\": " + to_string(id), 0) != string::npos;
+    if (!readWholeFile("tasks.journal", text)) return exists;
+
+    string needle = "\"id\":" + to_string(id);
+    for (size_t at = findStoredId(text, needle, 0); at != string::npos; ) {
+        size_t start = text.rfind('\n', at);
+        start = start == string::npos ? 0 : start + 1;
+        size_t end = text.find('\n', at);
+        if (end == string::npos) end = text.size();
+        json entry;
+        try {
+            entry = json::parse(text.begin() + start, text.begin() + end);
+        } catch (...) {
+            entry = json();   // torn last line
+        }
+        if (entry.is_object() && entry.value("id", 0u) == id) {
+            string op = entry.value("op", "");
+            if (op == "add") exists = true;
+            else if (op == "delete") exists = false;
+        }
+        at = end < text.size() ? findStoredId(text, needle, end) : string::npos;
     }
-    
+    return exists;
+}
+
+// add and done only append, and each reads the journal, so past this size
+// it is folded into tasks.json first
+const size_t ONE_SHOT_JOURNAL_MAX = 256 * 1024;
+
+// Runs one full load and save before an append when the journal has grown
+// too long, or when tasks.json is from before ids were stored (no nextId),
+// so these commands use the same ids list shows
+void prepareForAppend() {
+    bool legacy = fileSize("tasks.json") > 0 && storedCounter("nextId") == 0;
+    if (!legacy && fileSize("tasks.journal") < ONE_SHOT_JOURNAL_MAX) return;
+    vector<Task> tasks;
+    loadTasks(tasks);
     saveTasks(tasks);
-    cout << "  " << GREEN << "[V]" << RESET << " Task updated successfully!\n";
 }
 
-void searchTasks(const vector<Task>& tasks) {
-    if (tasks.empty()) {
-        cout << "\n  [i] No tasks to search.\n";
-        return;
+int commandAdd(const vector<string>& args) {
+    string text;
+    for (size_t i = 1; i < args.size(); ++i) text += (i > 1 ? " " : "") + args[i];
+
+    BatchFields f;
+    string error;
+    if (!parseBatchFields(text, f, error)) {
+        cout << "  " << RED << "[X]" << RESET << " " << error << ".\n";
+        return 1;
+    }
+    if (f.title.empty()) {
+        cout << "  " << RED << "[X]" << RESET << " Task title cannot be empty.\n";
+        return 1;
     }
 
-    cout << "\n  ========================== SEARCH TASKS =========================\n\n";
+    Task t;
+    t.title = f.title;
+    t.completed = f.done;
+    t.priority = f.priority;
+    t.dueDate = f.due;
+    t.created = (int64_t)time(nullptr);
 
-    string query = readLine("Search query: ");
-    
-    if (query.empty()) {
-        cout << "  " << RED << "[X]" << RESET << " Search query cannot be empty.\n";
-        return;
+    prepareForAppend();
+    StoreLock lock(true);
+    t.id = peekNextTaskId();
+    if (!appendJournal(journalTask("add", t))) {
+        cout << "  " << RED << "[X]" << RESET << " Cannot write tasks.journal.\n";
+        return 1;
     }
+    cout << "  " << GREEN << "[V]" << RESET << " Task " << t.id << " added successfully!\n";
+    return 0;
+}
 
-    cout << "\n  Search results:\n\n";
-    
-    bool found = false;
-    for (size_t i = 0; i < tasks.size(); ++i) {
-        if (tasks[i].title.find(query) != string::npos) {
-            cout << "  " << i + 1 << ". ";
-            
-            if (tasks[i].completed) {
-                cout << "[V] ";
-            } else {
-                cout << "[ ] ";
-            }
-            
-            cout << getPrioritySymbol(tasks[i].priority) << " " << tasks[i].title;
-            
-            if (!tasks[i].dueDate.empty()) {
-                cout << " (Due: " << tasks[i].dueDate << ")";
-            }
-            cout << '\n';
-            found = true;
-        }
+int commandDone(const vector<string>& args) {
+    uint32_t id;
+    string rest, error;
+    if (args.size() != 2 || !takeTaskId(args[1], id, rest, error)) {
+        cout << "  " << RED << "[X]" << RESET << " Usage: done ID\n";
+        return 1;
     }
-    
-    if (!found) {
-        cout << "  [i] No tasks found matching \"" << query << "\"\n";
+    prepareForAppend();
+    StoreLock lock(true);
+    if (!storedTaskExists(id)) {
+        cout << "  " << RED << "[X]" << RESET << " No task with id " << id << ".\n";
+        return 1;
     }
-    cout << '\n';
+    if (!appendJournal({{"op", "done"}, {"id", id}})) {
+        cout << "  " << RED << "[X]" << RESET << " Cannot write tasks.journal.\n";
+        return 1;
+    }
+    cout << "  " << GREEN << "[V]" << RESET << " Task " << id << " completed!\n";
+    return 0;
 }
 
-void sortTasks(vector<Task>& tasks) {
+int commandList() {
+    vector<Task> tasks;
+    loadTasks(tasks);
+    loadViews();
     if (tasks.empty()) {
-        cout << "\n  [i] No tasks to sort.\n";
-        return;
+        cout << "  [i] No tasks found.\n";
+        return 0;
     }
+    writeOutput(pageRows(tasks, 0, tasks.size(), 0));
+    return 0;
+}
 
-    cout << "\n  =========================== SORT TASKS ===========================\n\n";
-
-    int opt = readInt("Sort by (1 = Priority, 2 = Completion): ");
-    
-    saveState(tasks);
-
-    if (opt == 1) {
-        sort(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) {
-            return a.priority > b.priority;
-        });
-        cout << "  " << GREEN << "[V]" << RESET << " Tasks sorted by priority!\n";
-    } else if (opt == 2) {
-        sort(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) {
-            return a.completed < b.completed;
-        });
-        cout << "  " << GREEN << "[V]" << RESET << " Tasks sorted by completion status!\n";
-    } else {
-        cout << "  " << RED << "[X]" << RESET << " Invalid option.\n";
-        undoStack.pop();
-        return;
+int commandSearch(const vector<string>& args) {
+    string query;
+    for (size_t i = 1; i < args.size(); ++i) query += (i > 1 ? " " : "") + args[i];
+    if (query.empty()) {
+        cout << "  " << RED << "[X]" << RESET << " Search query cannot be empty.\n";
+        return 1;
+    }
+    QueryNode parsed;
+    string error;
+    if (!parseQuery(query, parsed, error)) {
+        cout << "  " << RED << "[X]" << RESET << " " << error << ".\n";
+        return 1;
     }
 
-    saveTasks(tasks);
-}
-
-void undo(vector<Task>& tasks) {
-    if (undoStack.empty()) {
-        cout << "\n  " << CYAN << "[i]" << RESET << " Nothing to undo.\n";
-        return;
+    vector<Task> tasks;
+    loadTasks(tasks);
+    loadViews();
+    QueryResult res = computeSearch(tasks, 3, query, parsed);
+    outputBuffer.clear();
+    for (uint32_t i : res.matches) {
+        appendTaskRow(outputBuffer, tasks[i], displayNumber(tasks, i));
+        outputBuffer += '\n';
     }
-    
-    redoStack.push(tasks);
-    tasks = undoStack.top();
-    undoStack.pop();
-    saveTasks(tasks);
-    
-    cout << "  " << GREEN << "[V]" << RESET << " Undo successful!\n";
+    writeOutput(outputBuffer);
+    if (res.matches.empty()) cout << "  [i] No tasks found matching \"" << query << "\"\n";
+    return 0;
 }
 
-void redo(vector<Task>& tasks) {
-    if (redoStack.empty()) {
-        cout << "\n  " << CYAN << "[i]" << RESET << " Nothing to redo.\n";
-        return;
+// -1 when args do not name a one-shot command
+int runOneShot(const vector<string>& args) {
+    if (args.empty()) return -1;
+    if (args[0] == "add" || args[0] == "done" || args[0] == "list" || args[0] == "search") {
+        string request, reply;
+        for (const auto& a : args) request += (request.empty() ? "" : " ") + a;
+        bool ok;
+        if (daemonRequest(request, reply, ok)) return printDaemonReply(ok, reply);
     }
-    
-    undoStack.push(tasks);
-    tasks = redoStack.top();
-    redoStack.pop();
-    saveTasks(tasks);
-    
-    cout << "  " << GREEN << "[V]" << RESET << " Redo successful!\n";
+    if (args[0] == "add") return commandAdd(args);
+    if (args[0] == "done") return commandDone(args);
+    if (args[0] == "list") return commandList();
+    if (args[0] == "search") return commandSearch(args);
+    return -1;
 }
 
 // ═══════════════════════════════════════════════════════════════════
 // MAIN FUNCTION
 // ═══════════════════════════════════════════════════════════════════
 
-int main() {
+int main(int argc, char* argv[]) {
     setupConsole();
+
+    vector<string> args(argv + 1, argv + argc);
+    if (!takeOutputFormat(args)) {
+        cout << "  [X] Unknown --format. Use color, plain, tsv or jsonl.\n";
+        return 1;
+    }
+
+    auto table = find(args.begin(), args.end(), "--table");
+    if (table != args.end()) {
+        tableLayout = true;
+        args.erase(table);
+    }
+
+    int status = runOneShot(args);
+    if (status >= 0) return status;
+
+    if (!args.empty() && args[0] == "--daemon") return runDaemon();
+    if (!args.empty() && args[0] == "--client") return runClient(args);
+    if (!args.empty() && args[0] == "--stdio-rpc") return runStdioRpc();
+
+    if (!args.empty() && args[0] == "--batch") {
+        vector<Task> tasks;
+        loadTasks(tasks);
+        loadViews();
+        return runBatch(tasks, args.size() >= 2 ? args[1] : "-");
+    }
+
+    if (!args.empty() && args[0] == "--bench-render") {
+        runRenderBenchmark(args.size() >= 2 ? strtoul(args[1].c_str(), nullptr, 10) : 100000);
+        return 0;
+    }
     
+    // Load and warm the indexes while the banner plays; anything the
+    // loaders print is held back and shown under the banner
+    thread banner;
+    if (outputFormat == OutputFormat::Color) banner = thread(displayWelcomeBanner);
+    ostringstream notices;
+    streambuf* console = cout.rdbuf(notices.rdbuf());
+
     vector<Task> tasks;
     loadTasks(tasks);
+    loadViews();
+    activeView(tasks);
+    ensureTaskIndex(tasks);
 
-    displayWelcomeBanner();
+    startupDone = true;
+    if (banner.joinable()) banner.join();
+    cout.rdbuf(console);
+    cout << notices.str();
 
     while (true) {
         displayMenu();
 
-        int choice = readInt("Choice: ");
+        int choice = readChoice("Choice: ");
 
         switch (choice) {
             case 1:
@@ -550,6 +5631,10 @@ int main() {
                 redo(tasks);
                 break;
 
+            case 0:
+                showUrgentTasks(tasks);
+                break;
+
             case 9:
                 cout << "\n";
                 cout << "  ============================================================\n";
@@ -561,7 +5646,7 @@ int main() {
                 return 0;
 
             default:
-                cout << "  " << RED << "[X]" << RESET << " Invalid option. Please choose 1-9.\n";
+                cout << "  " << RED << "[X]" << RESET << " Invalid option. Please choose 0-9.\n";
                 break;
         }
     }